@@ -0,0 +1,415 @@
+/*
+ * Copyright (C) 2025 comparchitect (https://github.com/comparchitect)
+ */
+
+/*
+ * .ambe v2: the same packed frames as v1, but stored in 512-byte blocks
+ * that carry when each burst arrived and which call it belongs to, with an
+ * index of calls at the end of the file. A reader goes from the file
+ * header to the index and from an index entry straight to the first block
+ * of a call, without touching the frames in between.
+ *
+ * Layout, in kBlockBytes units:
+ *   block 0       FileHeader
+ *   blocks 1..    DataBlocks, a call's blocks contiguous, and IndexPages
+ *                 between calls whenever a page of call entries fills up
+ *   last block    the trailing IndexPage, which FileHeader::index_block
+ *                 points at; each page links to the one before it
+ *
+ * A file that was never closed (power cut, card pulled) has no trailing
+ * index; its data blocks are still complete and can be read in order.
+ *
+ * Data blocks carry a CRC32. Blocks sit at fixed offsets, so a reader that
+ * finds one with a bad CRC, wrong magic or wrong sequence number counts
+ * it, moves on to the next 512-byte boundary and keeps decoding.
+ * v1 files keep their own header and are told apart by the magic, so
+ * ambe_log::validate() is unchanged.
+ */
+
+#ifndef __AMBE_LOG_V2_H__
+#define __AMBE_LOG_V2_H__
+
+#include "apps/ambe_log_format.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace ambe_log {
+namespace v2 {
+
+constexpr size_t kBlockBytes = 512;
+constexpr uint16_t kVersion = 2;
+constexpr char kMagic[8] = {'A', 'M', 'B', 'E', 'L', 'O', 'G', '2'};
+
+// Timestamps are the DSD baseband's 48 kHz sample index
+constexpr uint32_t kTimestampRate = 48000;
+constexpr uint32_t kFrameSamples = kTimestampRate / 50;  // 20 ms per frame
+constexpr size_t kFramesPerBurst = 3;
+constexpr size_t kBurstsPerBlock = 11;
+constexpr size_t kFramesPerBlock = kBurstsPerBlock * kFramesPerBurst;
+
+// By default a call ends when no burst arrives on its channel for this long
+constexpr uint64_t kCallGapSamples = kTimestampRate;
+
+// Readers take this many bad blocks in a row as the end of the data
+constexpr uint32_t kMaxCorruptRun = 64;
+
+constexpr uint32_t kNoBlock = 0xFFFFFFFFu;
+constexpr uint16_t kDataMagic = 0x4244;   // "DB"
+constexpr uint16_t kIndexMagic = 0x4249;  // "IB"
+
+enum BlockFlags : uint8_t {
+    kCallStart = 1u << 0,
+    kCallEnd = 1u << 1,
+    kHasCrc = 1u << 2  // crc32 is set; blocks without it are not checked
+};
+
+/* BlockHeader::sync and CallEntry::sync hold the SyncPatternId in their low
+ * bits and, in the top two, the timeslots voice was heard on: in the
+ * block's bursts, or anywhere in the call. Neither is set for MS bursts,
+ * which do not carry their slot, or in files written before the flags. */
+constexpr uint8_t kSyncPatternMask = 0x3Fu;
+constexpr uint8_t kSlot1 = 1u << 6;
+constexpr uint8_t kSlot2 = 1u << 7;
+
+constexpr uint8_t slot_flag(uint8_t slot) {
+    return (slot == 1) ? kSlot1 : (slot == 2) ? kSlot2 : 0;
+}
+
+/* RTC time in 32 bits at one-second resolution: years since 2000 (6),
+ * month (4), day (5), hour (5), minute (6), second (6). */
+constexpr uint32_t pack_time(uint16_t year, uint8_t month, uint8_t day, uint8_t hour, uint8_t minute, uint8_t second) {
+    return (static_cast<uint32_t>((year - 2000u) & 0x3Fu) << 26) | (static_cast<uint32_t>(month & 0x0Fu) << 22) |
+           (static_cast<uint32_t>(day & 0x1Fu) << 17) | (static_cast<uint32_t>(hour & 0x1Fu) << 12) |
+           (static_cast<uint32_t>(minute & 0x3Fu) << 6) | static_cast<uint32_t>(second & 0x3Fu);
+}
+
+constexpr uint8_t time_hour(uint32_t packed) { return static_cast<uint8_t>((packed >> 12) & 0x1Fu); }
+constexpr uint8_t time_minute(uint32_t packed) { return static_cast<uint8_t>((packed >> 6) & 0x3Fu); }
+constexpr uint8_t time_second(uint32_t packed) { return static_cast<uint8_t>(packed & 0x3Fu); }
+
+struct FileHeader {
+    char magic[8];
+    uint16_t version;
+    uint16_t block_bytes;
+    uint16_t frame_bytes;
+    uint16_t frames_per_block;
+    uint32_t timestamp_rate;
+    uint32_t rtc_start;    // pack_time() when the file was created
+    uint32_t index_block;  // Trailing IndexPage, kNoBlock until closed
+    uint32_t call_count;
+    uint32_t block_count;  // Blocks after this one
+    uint8_t reserved[kBlockBytes - 36];
+};
+
+struct BlockHeader {
+    uint16_t magic;  // kDataMagic
+    uint8_t flags;   // BlockFlags
+    uint8_t burst_count;
+    uint32_t sequence;      // This block's number in the file
+    uint64_t first_sample;  // Timestamp of the first burst
+    uint32_t call_id;       // Calls are numbered from 0 in file order
+    uint32_t rtc;           // pack_time() at the first burst
+    uint8_t channel;
+    uint8_t sync;  // SyncPatternId of the call's first burst; slot flags of this block
+    uint8_t reserved[2];
+    uint32_t crc32;  // Of the whole block with this field zero
+};
+
+struct DataBlock {
+    BlockHeader header;
+    // Burst n starts at first_sample + burst_offset[n]; its frames follow
+    // at kFrameSamples intervals
+    uint32_t burst_offset[kBurstsPerBlock];
+    uint8_t frames[kFramesPerBlock][kFrameBytes];
+    uint8_t reserved[kBlockBytes - sizeof(BlockHeader) - 4 * kBurstsPerBlock - kFramesPerBlock * kFrameBytes];
+
+    size_t frame_count() const { return static_cast<size_t>(header.burst_count) * kFramesPerBurst; }
+
+    uint64_t frame_sample(size_t frame) const {
+        return header.first_sample + burst_offset[frame / kFramesPerBurst] + (frame % kFramesPerBurst) * kFrameSamples;
+    }
+};
+
+struct CallEntry {
+    uint32_t first_block;
+    uint32_t frame_count;
+    uint32_t rtc;  // pack_time() at the call's first burst
+    uint8_t channel;
+    uint8_t sync;      // SyncPatternId of the first burst, slot flags of the call
+    uint16_t seconds;  // First to last burst, saturated
+};
+
+struct IndexHeader {
+    uint16_t magic;  // kIndexMagic
+    uint16_t entry_count;
+    uint32_t sequence;    // Same place as BlockHeader::sequence
+    uint32_t first_call;  // call_id of entries[0]
+    uint32_t previous_page;  // kNoBlock on the first page
+};
+
+constexpr size_t kEntriesPerPage = (kBlockBytes - sizeof(IndexHeader)) / sizeof(CallEntry);
+
+struct IndexPage {
+    IndexHeader header;
+    CallEntry entries[kEntriesPerPage];
+};
+
+static_assert(sizeof(FileHeader) == kBlockBytes, "v2 file header is one block");
+static_assert(sizeof(BlockHeader) == 32, "v2 block header layout");
+static_assert(sizeof(DataBlock) == kBlockBytes, "v2 data block is one block");
+static_assert(sizeof(IndexPage) == kBlockBytes, "v2 index page is one block");
+
+/* CRC-32 (IEEE 802.3, reflected), four bits per step from a 16-entry
+ * table. A block costs about 1k table steps, once per 0.66 s of audio. */
+inline uint32_t crc32(const void* data, size_t size, uint32_t crc = 0) {
+    static constexpr uint32_t kTable[16] = {
+        0x00000000u, 0x1DB71064u, 0x3B6E20C8u, 0x26D930ACu, 0x76DC4190u, 0x6B6B51F4u, 0x4DB26158u, 0x5005713Cu,
+        0xEDB88320u, 0xF00F9344u, 0xD6D6A3E8u, 0xCB61B38Cu, 0x9B64C2B0u, 0x86D3D2D4u, 0xA00AE278u, 0xBDBDF21Cu};
+    const auto* bytes = static_cast<const uint8_t*>(data);
+    crc = ~crc;
+    for (size_t i = 0; i < size; ++i) {
+        crc ^= bytes[i];
+        crc = (crc >> 4) ^ kTable[crc & 0x0Fu];
+        crc = (crc >> 4) ^ kTable[crc & 0x0Fu];
+    }
+    return ~crc;
+}
+
+inline uint32_t block_crc(const DataBlock& block) {
+    static constexpr uint8_t kZero[sizeof(block.header.crc32)] = {};
+    const auto* bytes = reinterpret_cast<const uint8_t*>(&block);
+    const size_t field = offsetof(BlockHeader, crc32);
+    uint32_t crc = crc32(bytes, field);
+    crc = crc32(kZero, sizeof(kZero), crc);
+    return crc32(bytes + field + sizeof(kZero), sizeof(block) - field - sizeof(kZero), crc);
+}
+
+inline FileHeader make_header(uint32_t rtc_start) {
+    FileHeader header{};
+    std::memcpy(header.magic, kMagic, sizeof(header.magic));
+    header.version = kVersion;
+    header.block_bytes = kBlockBytes;
+    header.frame_bytes = kFrameBytes;
+    header.frames_per_block = kFramesPerBlock;
+    header.timestamp_rate = kTimestampRate;
+    header.rtc_start = rtc_start;
+    header.index_block = kNoBlock;
+    return header;
+}
+
+/* True for a v2 header; a v1 file fails this and goes to validate(). */
+inline bool is_v2(const void* data, size_t size) {
+    return (size >= sizeof(kMagic)) && (std::memcmp(data, kMagic, sizeof(kMagic)) == 0);
+}
+
+inline bool validate(const FileHeader& header) {
+    return is_v2(&header, sizeof(header)) && header.version == kVersion && header.block_bytes == kBlockBytes &&
+           header.frame_bytes == kFrameBytes && header.frames_per_block == kFramesPerBlock;
+}
+
+inline bool is_data_block(const DataBlock& block, uint32_t sequence) {
+    return block.header.magic == kDataMagic && block.header.sequence == sequence &&
+           block.header.burst_count <= kBurstsPerBlock &&
+           (!(block.header.flags & kHasCrc) || block.header.crc32 == block_crc(block));
+}
+
+inline bool is_index_page(const IndexPage& page, uint32_t sequence) {
+    return page.header.magic == kIndexMagic && page.header.sequence == sequence &&
+           page.header.entry_count <= kEntriesPerPage;
+}
+
+enum class BlockKind : uint8_t {
+    Data = 0,
+    Index,
+    Corrupt
+};
+
+/* What a reader found at block sequence. Index pages have no CRC; a
+ * damaged one costs nothing but its calls' shortcut. */
+inline BlockKind classify_block(const DataBlock& block, uint32_t sequence) {
+    if (block.header.magic == kIndexMagic && block.header.sequence == sequence) {
+        return BlockKind::Index;
+    }
+    return is_data_block(block, sequence) ? BlockKind::Data : BlockKind::Corrupt;
+}
+
+/* Packs bursts into blocks and calls into index pages. Holds one block
+ * and one page; everything else goes straight to the sink, which needs
+ *   bool write(const void* data, size_t bytes)        append at the end
+ *   bool rewrite_header(const FileHeader& header)     overwrite block 0
+ * Every burst carries kFramesPerBurst packed frames. */
+class Writer {
+   public:
+    struct Burst {
+        uint64_t sample;
+        uint32_t rtc;
+        uint8_t channel;
+        uint8_t sync;           // SyncPatternId
+        uint8_t slot;           // 1 or 2, 0 when unknown
+        const uint8_t* frames;  // kFramesPerBurst * kFrameBytes
+    };
+
+    template <typename Sink>
+    bool begin(Sink& sink, uint32_t rtc_start) {
+        rtc_start_ = rtc_start;
+        next_block_ = 1;
+        call_open_ = false;
+        call_id_ = 0;
+        block_ = {};
+        start_page(kNoBlock);
+        const FileHeader header = make_header(rtc_start);
+        return sink.write(&header, sizeof(header));
+    }
+
+    template <typename Sink>
+    bool add_burst(Sink& sink, const Burst& burst) {
+        const bool new_call = !call_open_ || burst.channel != call_channel_ || burst.sample < last_sample_ ||
+                              (burst.sample - last_sample_) > call_gap_;
+        if (new_call) {
+            if (call_open_ && !end_call(sink)) {
+                return false;
+            }
+            call_open_ = true;
+            call_first_block_ = next_block_;
+            call_frames_ = 0;
+            call_first_sample_ = burst.sample;
+            call_rtc_ = burst.rtc;
+            call_channel_ = burst.channel;
+            call_sync_ = burst.sync & kSyncPatternMask;
+            call_slots_ = 0;
+        } else if (block_.header.burst_count == kBurstsPerBlock && !flush_block(sink, false)) {
+            return false;
+        }
+
+        if (block_.header.burst_count == 0) {
+            block_.header.magic = kDataMagic;
+            block_.header.flags = (next_block_ == call_first_block_) ? kCallStart : 0;
+            block_.header.sequence = next_block_;
+            block_.header.first_sample = burst.sample;
+            block_.header.call_id = call_id_;
+            block_.header.rtc = burst.rtc;
+            block_.header.channel = call_channel_;
+            block_.header.sync = call_sync_;
+        }
+        block_.header.sync |= slot_flag(burst.slot);
+        call_slots_ |= slot_flag(burst.slot);
+        const size_t index = block_.header.burst_count++;
+        block_.burst_offset[index] = static_cast<uint32_t>(burst.sample - block_.header.first_sample);
+        std::memcpy(block_.frames[index * kFramesPerBurst], burst.frames, kFramesPerBurst * kFrameBytes);
+        call_frames_ += kFramesPerBurst;
+        last_sample_ = burst.sample;
+        return true;
+    }
+
+    /* Closes the open call and writes the trailing index, then points the
+     * header at it. The file is complete after this. */
+    template <typename Sink>
+    bool finish(Sink& sink) {
+        if (call_open_ && !end_call(sink)) {
+            return false;
+        }
+        const uint32_t index_block = next_block_;
+        if (!write_page(sink)) {
+            return false;
+        }
+        FileHeader header = make_header(rtc_start_);
+        header.index_block = index_block;
+        header.call_count = call_id_;
+        header.block_count = next_block_ - 1;
+        return sink.rewrite_header(header);
+    }
+
+    /* Ends the call open on channel now instead of waiting for the gap; the
+     * receiver calls this on carrier loss or a voice terminator. */
+    template <typename Sink>
+    bool close_call(Sink& sink, uint8_t channel) {
+        if (!call_open_ || channel != call_channel_) {
+            return true;
+        }
+        return end_call(sink);
+    }
+
+    /* Silence on a channel longer than this starts a new call. */
+    void set_call_gap(uint64_t samples) { call_gap_ = samples; }
+    uint64_t call_gap() const { return call_gap_; }
+
+    uint32_t calls() const { return call_id_ + (call_open_ ? 1u : 0u); }
+    uint32_t blocks_written() const { return next_block_ - 1; }
+
+   private:
+    template <typename Sink>
+    bool flush_block(Sink& sink, bool call_end) {
+        if (call_end) {
+            block_.header.flags |= kCallEnd;
+        }
+        block_.header.flags |= kHasCrc;
+        block_.header.crc32 = block_crc(block_);
+        const bool ok = sink.write(&block_, sizeof(block_));
+        block_ = {};
+        ++next_block_;
+        return ok;
+    }
+
+    template <typename Sink>
+    bool end_call(Sink& sink) {
+        if (!flush_block(sink, true)) {
+            return false;
+        }
+        const uint64_t span = (last_sample_ - call_first_sample_) / kTimestampRate;
+        CallEntry& entry = page_.entries[page_.header.entry_count++];
+        entry.first_block = call_first_block_;
+        entry.frame_count = call_frames_;
+        entry.rtc = call_rtc_;
+        entry.channel = call_channel_;
+        entry.sync = call_sync_ | call_slots_;
+        entry.seconds = static_cast<uint16_t>((span > 0xFFFFu) ? 0xFFFFu : span);
+        call_open_ = false;
+        ++call_id_;
+
+        if (page_.header.entry_count == kEntriesPerPage) {
+            const uint32_t page_block = next_block_;
+            if (!write_page(sink)) {
+                return false;
+            }
+            start_page(page_block);
+        }
+        return true;
+    }
+
+    template <typename Sink>
+    bool write_page(Sink& sink) {
+        page_.header.sequence = next_block_;
+        ++next_block_;
+        return sink.write(&page_, sizeof(page_));
+    }
+
+    void start_page(uint32_t previous_page) {
+        page_ = {};
+        page_.header.magic = kIndexMagic;
+        page_.header.first_call = call_id_;
+        page_.header.previous_page = previous_page;
+    }
+
+    DataBlock block_{};
+    IndexPage page_{};
+    uint32_t rtc_start_{0};
+    uint32_t next_block_{1};
+    uint32_t call_id_{0};
+    uint64_t call_gap_{kCallGapSamples};
+    bool call_open_{false};
+    uint32_t call_first_block_{0};
+    uint32_t call_frames_{0};
+    uint64_t call_first_sample_{0};
+    uint64_t last_sample_{0};
+    uint32_t call_rtc_{0};
+    uint8_t call_channel_{0};
+    uint8_t call_sync_{0};
+    uint8_t call_slots_{0};
+};
+
+}  // namespace v2
+}  // namespace ambe_log
+
+#endif /*__AMBE_LOG_V2_H__*/
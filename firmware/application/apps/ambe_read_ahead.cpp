@@ -0,0 +1,91 @@
+/*
+ * Copyright (C) 2025 comparchitect (https://github.com/comparchitect)
+ */
+
+#include "ambe_read_ahead.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+void AmbeReadAhead::reset(File* file, Mutex* mutex, File::Offset position) {
+    file_ = file;
+    mutex_ = mutex;
+    for (auto& chunk : chunks_) {
+        chunk.size = 0;
+        chunk.used = 0;
+    }
+    current_ = 0;
+    position_ = position;
+    end_of_file_ = false;
+    bytes_read_ = 0;
+    read_ticks_ = 0;
+}
+
+File::Result<File::Size> AmbeReadAhead::fill(Chunk& chunk) {
+    const size_t request = kChunkBytes - static_cast<size_t>(position_ % kChunkBytes);
+
+    const systime_t start = chTimeNow();
+    chMtxLock(mutex_);
+    const auto result = file_->read(chunk.data.data(), request);
+    chMtxUnlock();
+    read_ticks_ += chTimeNow() - start;
+
+    if (!result.is_ok()) {
+        return result;
+    }
+    chunk.size = static_cast<size_t>(*result);
+    chunk.used = 0;
+    position_ += chunk.size;
+    bytes_read_ += chunk.size;
+    if (chunk.size < request) {
+        end_of_file_ = true;
+    }
+    return result;
+}
+
+void AmbeReadAhead::prefetch() {
+    Chunk& spare = chunks_[current_ ^ 1];
+    if (end_of_file_ || spare.used < spare.size || !file_) {
+        return;
+    }
+    fill(spare);
+}
+
+File::Result<File::Size> AmbeReadAhead::next(uint8_t* out, size_t count) {
+    size_t copied = 0;
+    while (copied < count) {
+        Chunk* chunk = &chunks_[current_];
+        if (chunk->used == chunk->size) {
+            // Current chunk spent: move to the spare, reading it now if
+            // prefetch() has not
+            current_ ^= 1;
+            chunk = &chunks_[current_];
+            if (chunk->used == chunk->size) {
+                if (end_of_file_) {
+                    break;
+                }
+                const auto result = fill(*chunk);
+                if (!result.is_ok()) {
+                    return result;
+                }
+                if (chunk->size == 0) {
+                    break;
+                }
+            }
+        }
+
+        const size_t take = std::min(count - copied, chunk->size - chunk->used);
+        std::memcpy(out + copied, chunk->data.data() + chunk->used, take);
+        chunk->used += take;
+        copied += take;
+    }
+    return File::Result<File::Size>{static_cast<File::Size>(copied)};
+}
+
+uint32_t AmbeReadAhead::kib_per_second() const {
+    // 1 kHz system tick: read_ticks_ is in milliseconds
+    if (read_ticks_ == 0) {
+        return 0;
+    }
+    return static_cast<uint32_t>((bytes_read_ * 1000u) / (static_cast<uint64_t>(read_ticks_) * 1024u));
+}
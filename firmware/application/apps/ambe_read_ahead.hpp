@@ -0,0 +1,67 @@
+/*
+ * Copyright (C) 2025 comparchitect (https://github.com/comparchitect)
+ */
+
+/*
+ * Read-ahead for .ambe input. Frames are 13 bytes, so reading them one by
+ * one costs a FatFs call (and the view's file mutex) per 20 ms of audio.
+ * This reads the file in sector-aligned chunks into two buffers and hands
+ * frames out from RAM: one chunk is consumed while the other is filled,
+ * from prefetch() calls made while the decode loop would otherwise sleep
+ * waiting on the baseband.
+ */
+
+#ifndef __AMBE_READ_AHEAD_H__
+#define __AMBE_READ_AHEAD_H__
+
+#include "ch.h"
+#include "file.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+class AmbeReadAhead {
+   public:
+    // Eight 512-byte sectors per read
+    static constexpr size_t kChunkBytes = 4096;
+
+    /* Reads from file at offset position onwards (the file must be there
+     * already), taking mutex around each read. The first chunk ends on a
+     * kChunkBytes file boundary so later reads are aligned. */
+    void reset(File* file, Mutex* mutex, File::Offset position);
+
+    /* Fills the spare chunk if it is empty. Cheap when there is nothing to
+     * do. A failed read is left for next() to retry and report. */
+    void prefetch();
+
+    /* Copies the next count bytes to out. Returns count, fewer at the end
+     * of the file (0 once it is exhausted), or the read error. */
+    File::Result<File::Size> next(uint8_t* out, size_t count);
+
+    uint64_t bytes_read() const { return bytes_read_; }
+
+    /* Average rate of the reads themselves, in KiB/s; 0 before the first
+     * read has taken measurable time. */
+    uint32_t kib_per_second() const;
+
+   private:
+    struct Chunk {
+        std::array<uint8_t, kChunkBytes> data{};
+        size_t size{0};
+        size_t used{0};
+    };
+
+    File::Result<File::Size> fill(Chunk& chunk);
+
+    File* file_{nullptr};
+    Mutex* mutex_{nullptr};
+    std::array<Chunk, 2> chunks_{};
+    size_t current_{0};
+    File::Offset position_{0};
+    bool end_of_file_{false};
+    uint64_t bytes_read_{0};
+    systime_t read_ticks_{0};
+};
+
+#endif /*__AMBE_READ_AHEAD_H__*/
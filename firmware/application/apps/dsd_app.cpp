@@ -31,9 +31,11 @@
 #include "rtc_time.hpp"
 #include "file_path.hpp"
 #include "apps/ambe_log_format.hpp"
+#include "apps/ambe_log_v2.hpp"
 #include "apps/ambe_processing.hpp"
 
 #include <algorithm>
+#include <array>
 #include <cstring>
 
 #ifndef DSDRX_USE_PREPARED_IMAGE
@@ -49,6 +51,32 @@ constexpr uint64_t kDefaultFrequency = 435000000ULL;
 constexpr size_t kAudioCaptureWriteSize = 2048;
 constexpr size_t kAudioCaptureBufferCount = 8;
 constexpr uint8_t kMaxLoggedFrameErrors = 12;  // Frames with more errors still get logged
+
+static_assert(AMBEVoiceBurstMessage::kMaxFrames == ambe_log::v2::kFramesPerBurst, "v2 blocks hold whole bursts");
+
+// Appends .ambe v2 blocks to the log file for ambe_log::v2::Writer
+struct LogSink {
+    File& file;
+
+    bool write(const void* data, size_t bytes) {
+        const auto result = file.write(data, bytes);
+        return result.is_ok() && *result == bytes;
+    }
+
+    bool rewrite_header(const ambe_log::v2::FileHeader& header) {
+        if (file.seek(0).is_error()) {
+            return false;
+        }
+        return write(&header, sizeof(header));
+    }
+};
+
+uint32_t rtc_now() {
+    rtc::RTC datetime;
+    rtc_time::now(datetime);
+    return ambe_log::v2::pack_time(datetime.year(), datetime.month(), datetime.day(),
+                                   datetime.hour(), datetime.minute(), datetime.second());
+}
 }  // namespace
 
 DSDView::DSDView(NavigationView& nav)
@@ -70,6 +98,7 @@ DSDView::DSDView(NavigationView& nav)
                   &text_bursts_label_,
                   &field_bursts_,
                   &check_log_to_sd_,
+                  &field_call_gap_,
                   #if DSD_AUDIO_TO_SD
                   &check_audio_to_sd_,
                   #endif
@@ -92,6 +121,7 @@ DSDView::DSDView(NavigationView& nav)
 
     check_log_to_sd_.hidden(true);
     check_log_to_sd_.set_value(false);
+    field_call_gap_.hidden(true);
     check_log_to_sd_.on_select = [this](Checkbox&, bool value) {
         if (value) {
             update_sd_card_availability();
@@ -103,6 +133,11 @@ DSDView::DSDView(NavigationView& nav)
         }
     };
 
+    field_call_gap_.set_by_value(static_cast<int32_t>(log_writer_.call_gap()));
+    field_call_gap_.on_change = [this](size_t, int32_t value) {
+        log_writer_.set_call_gap(static_cast<uint64_t>(value));
+    };
+
     #if DSD_AUDIO_TO_SD
     check_audio_to_sd_.hidden(true);
     check_audio_to_sd_.set_value(false);
@@ -170,13 +205,33 @@ void DSDView::on_voice_burst(const AMBEVoiceBurstMessage* message) {
     update_frame_status();
 #endif
 
-    if (!send_decode_request(message->data, frames)) {
+    if (!send_decode_request(*message, frames)) {
         text_status_.set("Frame error");
     }
 }
 
-bool DSDView::send_decode_request(const uint8_t* burst_bytes, uint8_t frame_count) {
-    if (!burst_bytes || frame_count == 0) {
+void DSDView::on_call_event(const DSDCallEventMessage* message) {
+    if (!message || !log_file_open_) {
+        return;
+    }
+
+    // Close the call's index entry now so the next burst on this channel
+    // starts a new one, however soon it follows
+    LogSink sink{log_file_};
+    if (!log_writer_.close_call(sink, message->channel)) {
+        text_status_.set("Log write err");
+        check_log_to_sd_.set_value(false);
+        close_log_file();
+        return;
+    }
+    if (log_writer_.blocks_written() != log_blocks_synced_) {
+        log_blocks_synced_ = log_writer_.blocks_written();
+        log_file_.sync();
+    }
+}
+
+bool DSDView::send_decode_request(const AMBEVoiceBurstMessage& message, uint8_t frame_count) {
+    if (frame_count == 0) {
         return true;
     }
 
@@ -187,54 +242,64 @@ bool DSDView::send_decode_request(const uint8_t* burst_bytes, uint8_t frame_coun
     update_frame_status();
 #endif
 
+    if (!logging_enabled()) {
+        return true;
+    }
+
     char ambe_frames[AMBEVoiceBurstMessage::kMaxFrames][4][24];
-    ambe_processing::deinterleave_ambe_burst(burst_bytes, ambe_frames);
+    ambe_processing::deinterleave_ambe_burst(message.data, ambe_frames);
 
+    std::array<uint8_t, AMBEVoiceBurstMessage::kMaxFrames * ambe_log::kFrameBytes> packed_burst{};
     for (uint8_t frame = 0; frame < frame_count; ++frame) {
-        if (!send_single_frame(ambe_frames[frame])) {
-            return false;
-        }
+        pack_log_frame(ambe_frames[frame], packed_burst.data() + frame * ambe_log::kFrameBytes);
     }
 
-    return true;
+    // v2 blocks hold whole bursts; the baseband never sends partial ones
+    if (frame_count < ambe_log::v2::kFramesPerBurst) {
+        return true;
+    }
+    return log_burst(message, packed_burst.data());
 }
 
-bool DSDView::send_single_frame(const char ambe_frame[4][24]) {
-    char ambe_fr_raw[4][24];
-    std::memcpy(ambe_fr_raw, ambe_frame, sizeof(ambe_fr_raw));
+void DSDView::pack_log_frame(const char ambe_frame[4][24], uint8_t* packed_out) {
+    char ambe_fr_capture[4][24];
+    std::memcpy(ambe_fr_capture, ambe_frame, sizeof(ambe_fr_capture));
+    char ambe_d[49]{};
+    int errs2 = 0;
+    ambe_processing::sanitize_frame(ambe_fr_capture, ambe_d, &errs2);
+    if (errs2 > static_cast<int>(kMaxLoggedFrameErrors)) {
+        ++frames_error_;
+    }
+    const auto packed = ambe_processing::pack_frame(ambe_fr_capture, static_cast<uint8_t>(errs2));
+    std::memcpy(packed_out, packed.data(), packed.size());
+}
 
-    if (logging_enabled()) {
-        char ambe_fr_capture[4][24];
-        std::memcpy(ambe_fr_capture, ambe_fr_raw, sizeof(ambe_fr_capture));
-        char ambe_d[49]{};
-        int errs2 = 0;
-        ambe_processing::sanitize_frame(ambe_fr_capture, ambe_d, &errs2);
-        if (errs2 > static_cast<int>(kMaxLoggedFrameErrors)) {
-            ++frames_error_;
-        }
-        auto packed = ambe_processing::pack_frame(ambe_fr_capture, static_cast<uint8_t>(errs2));
+bool DSDView::log_burst(const AMBEVoiceBurstMessage& message, const uint8_t* packed_frames) {
+    const ambe_log::v2::Writer::Burst burst{
+        message.start_sample,
+        rtc_now(),
+        message.channel,
+        message.sync,
+        message.slot,
+        packed_frames};
+
+    LogSink sink{log_file_};
+    if (!log_writer_.add_burst(sink, burst)) {
+        text_status_.set("Log write err");
+        check_log_to_sd_.set_value(false);
+        close_log_file();
+        return false;
+    }
+    frames_logged_ += ambe_log::v2::kFramesPerBurst;
 
-        auto write_result = log_file_.write(packed);
-        if (!write_result.is_ok() || *write_result != packed.size()) {
-            text_status_.set("Log write err");
-            check_log_to_sd_.set_value(false);
-            close_log_file();
-            return false;
-        }
-        ++frames_logged_;
-        if (errs2 > static_cast<int>(kMaxLoggedFrameErrors)) {
-#if DEBUG            
-            update_frame_status();
-#endif
-        }
-        if ((frames_logged_ % 50u) == 0u) {
-            log_file_.sync();
-        }
+    // Blocks reach the file every 33 frames; sync each one as it lands
+    if (log_writer_.blocks_written() != log_blocks_synced_) {
+        log_blocks_synced_ = log_writer_.blocks_written();
+        log_file_.sync();
+    }
 #if DEBUG
-        update_frame_status();
+    update_frame_status();
 #endif
-    }
-
     return true;
 }
 
@@ -273,6 +338,7 @@ void DSDView::update_sd_card_availability() {
     if (available != sd_card_available_) {
         sd_card_available_ = available;
         check_log_to_sd_.hidden(!sd_card_available_);
+        field_call_gap_.hidden(!sd_card_available_);
         #if DSD_AUDIO_TO_SD
         check_audio_to_sd_.hidden(!sd_card_available_);
         #endif
@@ -315,9 +381,8 @@ bool DSDView::open_log_file() {
         return false;
     }
 
-    const ambe_log::Header header = ambe_log::make_header();
-    auto write_header = log_file_.write(&header, sizeof(header));
-    if (!write_header.is_ok() || *write_header != sizeof(header)) {
+    LogSink sink{log_file_};
+    if (!log_writer_.begin(sink, rtc_now())) {
         text_status_.set("Header write err");
         log_file_.close();
         release_session_prefix_if_idle();
@@ -325,6 +390,7 @@ bool DSDView::open_log_file() {
     }
 
     log_file_open_ = true;
+    log_blocks_synced_ = 0;
     current_log_filename_ = filename;
     reset_frame_counters();
     text_status_.set("Logging " + filename);
@@ -333,6 +399,11 @@ bool DSDView::open_log_file() {
 
 void DSDView::close_log_file() {
     if (log_file_open_) {
+        // Close the last call and write the call index the player seeks with
+        LogSink sink{log_file_};
+        if (!log_writer_.finish(sink)) {
+            text_status_.set("Index write err");
+        }
         log_file_.sync();
         log_file_.close();
         log_file_open_ = false;
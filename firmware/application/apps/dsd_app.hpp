@@ -28,6 +28,8 @@
 #include "baseband_api.hpp"
 #include "message.hpp"
 #include "file.hpp"
+#include "apps/ambe_log_v2.hpp"
+
 // Define to 1 to enable Audio-to-SD capture UI/logic (disabled to save flash)
 #ifndef DSD_AUDIO_TO_SD
 #define DSD_AUDIO_TO_SD 0
@@ -56,9 +58,11 @@ class DSDView : public View {
    private:
     void on_stats(const DMRRxStatsMessage* message);
     void on_voice_burst(const AMBEVoiceBurstMessage* message);
+    void on_call_event(const DSDCallEventMessage* message);
 
-    bool send_decode_request(const uint8_t* burst_bytes, uint8_t frame_count);
-    bool send_single_frame(const char ambe_frame[4][24]);
+    bool send_decode_request(const AMBEVoiceBurstMessage& message, uint8_t frame_count);
+    void pack_log_frame(const char ambe_frame[4][24], uint8_t* packed_out);
+    bool log_burst(const AMBEVoiceBurstMessage& message, const uint8_t* packed_frames);
     void update_sd_card_availability();
     bool open_log_file();
     void close_log_file();
@@ -106,6 +110,16 @@ class DSDView : public View {
         "Log to SD",
         true};
 
+    // Silence that starts a new call in the log; carrier loss and MS or
+    // direct-mode terminators end a call sooner
+    OptionsField field_call_gap_{
+        {20 * 8, 4 * 16},
+        8,
+        {{"Gap 0.5s", static_cast<int32_t>(ambe_log::v2::kTimestampRate / 2)},
+         {"Gap 1s", static_cast<int32_t>(ambe_log::v2::kTimestampRate)},
+         {"Gap 2s", static_cast<int32_t>(ambe_log::v2::kTimestampRate * 2)},
+         {"Gap 5s", static_cast<int32_t>(ambe_log::v2::kTimestampRate * 5)}}};
+
     #if DSD_AUDIO_TO_SD
     Checkbox check_audio_to_sd_{
         {2 * 8, 5 * 16},
@@ -122,6 +136,8 @@ class DSDView : public View {
 
     bool sd_card_available_{false};
     File log_file_{};
+    ambe_log::v2::Writer log_writer_{};
+    uint32_t log_blocks_synced_{0};
     bool log_file_open_{false};
     std::string current_log_filename_{};
     std::string session_filename_prefix_{};
@@ -152,6 +168,12 @@ class DSDView : public View {
             on_voice_burst(reinterpret_cast<const AMBEVoiceBurstMessage*>(p));
         }};
 
+    MessageHandlerRegistration message_handler_call_event_{
+        Message::ID::DSDCallEvent,
+        [this](const Message* const p) {
+            on_call_event(reinterpret_cast<const DSDCallEventMessage*>(p));
+        }};
+
     #if DSD_AUDIO_TO_SD
     MessageHandlerRegistration message_handler_audio_capture_done_{
         Message::ID::CaptureThreadDone,
@@ -0,0 +1,27 @@
+/*
+ * Copyright (C) 2025 comparchitect (https://github.com/comparchitect)
+ */
+
+#include "mbe_rng.hpp"
+
+#include <cstdint>
+
+namespace {
+
+#if defined(MBE_RNG_THREAD_LOCAL)
+thread_local uint64_t rng_state = MBE_RNG_SEED;
+#else
+// The M4 runs one decoder; ChibiOS has no thread-local storage
+uint64_t rng_state = MBE_RNG_SEED;
+#endif
+
+}  // namespace
+
+extern "C" int mbe_rng_next(void) {
+    rng_state = rng_state * 6364136223846793005ULL + 1u;
+    return static_cast<int>((rng_state >> 32) & 0x7FFFFFFFu);
+}
+
+extern "C" void mbe_rng_seed(unsigned int seed) {
+    rng_state = seed;
+}
@@ -0,0 +1,42 @@
+/*
+ * Copyright (C) 2025 comparchitect (https://github.com/comparchitect)
+ */
+
+/*
+ * Random numbers for mbelib. mbelib draws the random phases of upper
+ * harmonics and unvoiced bands from rand(), so its output depends on how
+ * many numbers were drawn before. tools/get-mbelib.sh routes those calls
+ * here, which gives every decoder the same sequence the M4's newlib rand()
+ * gives a freshly started PA2D image:
+ *
+ * - mbe_rng_seed(MBE_RNG_SEED) goes with every decoder reset, on the M4
+ *   and in the host tools, so a decode never continues the previous one's
+ *   sequence.
+ * - Host builds define MBE_RNG_THREAD_LOCAL, so decoders on different
+ *   threads each draw their own sequence instead of sharing one.
+ *
+ * Included by the staged mbelib C sources as well as by C++.
+ */
+
+#ifndef __MBE_RNG_H__
+#define __MBE_RNG_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* newlib's initial rand() state. */
+#define MBE_RNG_SEED 1u
+
+/* Replaces rand(): newlib's 64-bit LCG, 0..0x7FFFFFFF (RAND_MAX on both
+ * newlib and glibc). */
+int mbe_rng_next(void);
+
+/* Replaces srand(). */
+void mbe_rng_seed(unsigned int seed);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /*__MBE_RNG_H__*/
@@ -0,0 +1,82 @@
+/*
+ * Copyright (C) 2025 comparchitect (https://github.com/comparchitect)
+ */
+
+/*
+ * AMBE+2 3600x2450 frame parameters, as .ambe captures hold them (DMR,
+ * NXDN, dPMR): unpacking a packed frame into mbelib's parameter bits and
+ * classifying it from its pitch index b0 without running the vocoder.
+ */
+
+#ifndef __MBE_VOCODER_H__
+#define __MBE_VOCODER_H__
+
+#include "apps/ambe_processing.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace mbe_vocoder {
+
+/* What a frame carries, read from its pitch parameter b0 and C0 error
+ * count without running the vocoder. Silence and erasure frames
+ * synthesize (near) silence; a repeat replays the previous frame. */
+enum class FrameKind : uint8_t {
+    Voice = 0,
+    Erasure,
+    Silence,
+    Tone,
+    Repeat
+};
+
+constexpr size_t kFrameSamples = 160;
+constexpr size_t kParamBits = 49;
+constexpr uint8_t kPitchLevels = 120;  // b0 120..127 are reserved
+
+constexpr FrameKind classify_pitch(uint8_t b0) {
+    return (b0 < kPitchLevels) ? FrameKind::Voice
+           : (b0 <= 123)       ? FrameKind::Erasure
+           : (b0 <= 125)       ? FrameKind::Silence
+                               : FrameKind::Tone;
+}
+
+/* b0 as assembled by mbe_decodeAmbe2450Parms(). */
+inline uint8_t pitch_index(const char* params) {
+    return static_cast<uint8_t>((params[0] << 6) | (params[1] << 5) | (params[2] << 4) |
+                                (params[3] << 3) | (params[37] << 2) | (params[38] << 1) |
+                                params[39]);
+}
+
+/* Unpacks one packed .ambe frame into its kParamBits parameter bits;
+ * returns the C0 error count stored at capture time. */
+inline uint8_t unpack(const uint8_t* packed, char* params) {
+    char ambe_fr[4][24];
+    const uint8_t errs2 = ambe_processing::unpack_frame(packed, ambe_fr);
+    ambe_processing::extract_ambe_data(ambe_fr, params);
+    return errs2;
+}
+
+inline FrameKind classify(const uint8_t* packed) {
+    char params[kParamBits] = {0};
+    const uint8_t errs2 = unpack(packed, params);
+    const FrameKind kind = classify_pitch(pitch_index(params));
+    // With more than three uncorrected C0 errors mbelib replays the
+    // previous parameters, and only mutes after three repeats in a row;
+    // an erasure b0 resets it regardless
+    if (errs2 > 3 && kind != FrameKind::Erasure) {
+        return FrameKind::Repeat;
+    }
+    return kind;
+}
+
+/* True for the frames mbelib answers with zeros and a parameter reset:
+ * b0 120..123, whatever the C0 error count. */
+inline bool resets_decoder(const uint8_t* packed) {
+    char params[kParamBits] = {0};
+    unpack(packed, params);
+    return classify_pitch(pitch_index(params)) == FrameKind::Erasure;
+}
+
+}  // namespace mbe_vocoder
+
+#endif /*__MBE_VOCODER_H__*/
@@ -13,6 +13,7 @@
 #include "file_path.hpp"
 #include "rtc_time.hpp"
 #include "apps/ambe_log_format.hpp"
+#include "apps/ambe_log_v2.hpp"
 #include "ui_fileman.hpp"
 #include "event_m0.hpp"
 
@@ -21,6 +22,7 @@
 #include <cstring>
 #include <cstdio>
 #include <cstdarg>
+#include <cstddef>
 #include <cmath>
 
 #ifndef MBELIB_USE_PREPARED_IMAGE
@@ -33,13 +35,31 @@ namespace ui {
 
 namespace {
 constexpr size_t kSamplesPerFrame = AMBEPCMFrameMessage::kMaxSamples;
-constexpr uint16_t kPlaybackSampleRate = 48000;
-constexpr size_t kWavHeaderSize = 44;
 constexpr size_t kDecodeThreadStack = 4096;
 constexpr tprio_t kDecodeThreadPriority = NORMALPRIO + 4;
-constexpr uint32_t kMaxInFlightFrames = 4;
+constexpr uint32_t kMaxInFlightFrames = mbelib_audio::kMaxFramesInFlight;
 constexpr systime_t kInflightSleepMs = 5;
 
+// WAV playback is sent to the PA2D baseband in 10 ms chunks at the 12 kHz
+// codec rate
+constexpr uint32_t kPlaybackChunkMs = 10;
+constexpr uint32_t kPlaybackCodecRate = 12000;
+constexpr size_t kPlaybackChunkSamples = kPlaybackCodecRate * kPlaybackChunkMs / 1000;
+constexpr size_t kPlaybackDecimation = mbelib_audio::kPlaybackSampleRate / kPlaybackCodecRate;
+
+// Decode checkpoints every 30 s of audio; a resume replays 25 frames (as
+// ambe2wav --split does at its cuts) before writing again
+constexpr uint32_t kCheckpointFrames = 1500;
+constexpr uint32_t kResumeWarmupFrames = 25;
+constexpr uint32_t kCheckpointMagic = 0x4B434D41;  // "AMCK"
+
+// A manifest identifies its input by size and two CRCs: the part of the
+// header that never changes (v1, or v2 up to index_block), and the last
+// 4 KB decoded. That keeps the check to two short reads per file
+constexpr uint32_t kManifestMagic = 0x464D4D41;  // "AMMF"
+constexpr size_t kManifestHeadBytes = 24;
+constexpr size_t kManifestTailBytes = 4096;
+
 class MutexGuard {
    public:
     explicit MutexGuard(Mutex& m)
@@ -58,6 +78,41 @@ class MutexGuard {
     Mutex& mutex_;
 };
 
+std::filesystem::path manifest_path(const std::filesystem::path& wav) {
+    auto path = wav;
+    path.replace_extension(".manifest");
+    return path;
+}
+
+/* CRCs of the input's first kManifestHeadBytes and of the (up to)
+ * kManifestTailBytes before size. */
+bool input_fingerprint(File& input, File::Size size, uint32_t& head, uint32_t& tail) {
+    if (size < kManifestHeadBytes) {
+        return false;
+    }
+    auto buffer = std::make_unique<std::array<uint8_t, kManifestTailBytes>>();
+    if (input.seek(0).is_error()) {
+        return false;
+    }
+    auto read = input.read(buffer->data(), kManifestHeadBytes);
+    if (!read.is_ok() || *read != kManifestHeadBytes) {
+        return false;
+    }
+    head = ambe_log::v2::crc32(buffer->data(), kManifestHeadBytes);
+
+    const File::Size start = std::max<File::Size>(kManifestHeadBytes, (size > kManifestTailBytes) ? size - kManifestTailBytes : 0);
+    const size_t count = static_cast<size_t>(size - start);
+    if (input.seek(start).is_error()) {
+        return false;
+    }
+    read = input.read(buffer->data(), count);
+    if (!read.is_ok() || *read != count) {
+        return false;
+    }
+    tail = ambe_log::v2::crc32(buffer->data(), count);
+    return true;
+}
+
 
 }  // namespace
 
@@ -74,19 +129,65 @@ MBELIBView::MBELIBView(NavigationView& nav)
                   &button_select_file_,
                   &button_decode_,
                   &button_play_wav_,
+                  &button_play_ambe_,
+                  &button_batch_,
+                  &field_wav_rate_,
+                  &field_wav_codec_,
+                  &field_call_,
                   &text_m0_stats_});
 
+    field_wav_rate_.set_by_value(wav_sample_rate_);
+    field_wav_rate_.on_change = [this](size_t, int32_t value) {
+        wav_sample_rate_ = static_cast<uint32_t>(value);
+    };
+
+    field_wav_codec_.set_by_value(static_cast<int32_t>(wav_format_));
+    field_wav_codec_.on_change = [this](size_t, int32_t value) {
+        wav_format_ = static_cast<mbelib_audio::WavFormat>(value);
+    };
+
+    field_call_.hidden(true);
+    field_call_.on_change = [this](size_t, int32_t value) {
+        // A running decode keeps its own copy; the rest waits for it to end
+        selected_call_ = value;
+        if (decode_in_progress_) {
+            return;
+        }
+        total_frames_expected_ = frames_in_selection();
+        wav_file_ = wav_path();
+        wav_available_ = wav_exists();
+        update_play_button();
+        update_ready_status();
+    };
+
     button_select_file_.on_select = [this](Button&) {
         select_file();
     };
 
     button_decode_.on_select = [this](Button&) {
-        decode_selected_file();
+        start_session(Session::DecodeToWav);
+    };
+
+    button_play_ambe_.on_select = [this](Button&) {
+        if (decode_in_progress_ && stream_mode_) {
+            decode_abort_ = true;
+        } else {
+            start_session(Session::PlayAmbe);
+        }
+    };
+
+    button_batch_.on_select = [this](Button&) {
+        if (batch_active_) {
+            batch_stop_ = true;
+            decode_abort_ = true;
+        } else {
+            start_batch();
+        }
     };
 
     button_play_wav_.hidden(true);
     button_play_wav_.on_select = [this](Button&) {
-        if (is_playing_) {
+        if (wav_playing()) {
             stop_wav_playback();
         } else {
             start_wav_playback();
@@ -103,6 +204,9 @@ MBELIBView::~MBELIBView() {
     decode_abort_ = true;
     decode_in_progress_ = false;
     stop_wav_playback();
+    if (stream_mode_) {
+        stop_stream_audio();
+    }
     close_file();
     output_ready_ = false;
     close_output_file();
@@ -140,26 +244,121 @@ void MBELIBView::select_file() {
         selected_file_ = new_file_path;
         text_selected_file_.set("File: " + new_file_path.filename().string());
         text_selected_file_.set_dirty();
-        wav_file_ = new_file_path;
-        wav_file_.replace_extension(".wav");
-        wav_available_ = wav_exists();
-        update_play_button();
 
-        total_frames_expected_ = 0;
-        File info_file;
-        if (!decode_in_progress_ && !info_file.open(new_file_path, true, false)) {
-            const auto size = info_file.size();
-            info_file.close();
-            if (size >= sizeof(ambe_log::Header)) {
-                const auto payload = size - sizeof(ambe_log::Header);
-                total_frames_expected_ = static_cast<uint32_t>(payload / ambe_log::kFrameBytes);
-            }
+        if (!decode_in_progress_) {
+            load_file_info(new_file_path);
+            total_frames_expected_ = frames_in_selection();
         }
+        wav_file_ = wav_path();
+        wav_available_ = wav_exists();
+        update_play_button();
         update_ready_status();
     };
 }
 
-void MBELIBView::decode_selected_file() {
+void MBELIBView::load_file_info(const std::filesystem::path& path) {
+    calls_.clear();
+    first_listed_call_ = 0;
+    file_frames_ = 0;
+    selected_call_ = -1;
+    input_size_ = 0;
+
+    File info;
+    if (!info.open(path, true, false)) {
+        const auto size = info.size();
+        input_size_ = size;
+        // A v2 header is a whole block; reading one from a short v1 file
+        // just comes back short
+        auto header = std::make_unique<ambe_log::v2::FileHeader>();
+        const auto read = info.read(header.get(), sizeof(*header));
+        if (read.is_ok() && *read == sizeof(*header) && ambe_log::v2::validate(*header)) {
+            load_call_index(info, *header, size);
+        } else if (size >= sizeof(ambe_log::Header)) {
+            const auto payload = size - sizeof(ambe_log::Header);
+            file_frames_ = static_cast<uint32_t>(payload / ambe_log::kFrameBytes);
+        }
+        info.close();
+    }
+    update_call_options();
+}
+
+void MBELIBView::load_call_index(File& file, const ambe_log::v2::FileHeader& header, File::Size size) {
+    using namespace ambe_log::v2;
+    const uint32_t blocks = static_cast<uint32_t>(size / kBlockBytes);
+
+    if (header.index_block == kNoBlock) {
+        // Never closed: no call list, and the frame count is an estimate
+        file_frames_ = (blocks > 1) ? (blocks - 1) * kFramesPerBlock : 0;
+        return;
+    }
+
+    // Pages link back from the trailing one, newest calls first. Keep the
+    // newest kMaxListedCalls entries; every page counts towards the total
+    auto page = std::make_unique<IndexPage>();
+    uint32_t page_block = header.index_block;
+    for (uint32_t visited = 0; page_block < blocks && visited < blocks; ++visited) {
+        if (file.seek(static_cast<File::Offset>(page_block) * kBlockBytes).is_error()) {
+            break;
+        }
+        const auto read = file.read(page.get(), sizeof(*page));
+        if (!read.is_ok() || *read != sizeof(*page) || !is_index_page(*page, page_block)) {
+            break;
+        }
+
+        const size_t count = page->header.entry_count;
+        for (size_t i = 0; i < count; ++i) {
+            file_frames_ += page->entries[i].frame_count;
+        }
+        const size_t room = kMaxListedCalls - calls_.size();
+        const size_t keep = std::min(count, room);
+        if (keep > 0) {
+            calls_.insert(calls_.begin(), page->entries + (count - keep), page->entries + count);
+            first_listed_call_ = page->header.first_call + static_cast<uint32_t>(count - keep);
+        }
+        page_block = page->header.previous_page;
+    }
+}
+
+void MBELIBView::update_call_options() {
+    OptionsField::options_t options{{"All calls", -1}};
+    for (size_t i = 0; i < calls_.size(); ++i) {
+        const auto& call = calls_[i];
+        const uint32_t id = first_listed_call_ + static_cast<uint32_t>(i);
+        options.emplace_back("#" + to_string_dec_uint(id + 1) + " " +
+                                 to_string_dec_uint(ambe_log::v2::time_hour(call.rtc), 2, '0') + ":" +
+                                 to_string_dec_uint(ambe_log::v2::time_minute(call.rtc), 2, '0') + ":" +
+                                 to_string_dec_uint(ambe_log::v2::time_second(call.rtc), 2, '0') + " " +
+                                 to_string_dec_uint(call.seconds) + "s",
+                             static_cast<int32_t>(id));
+    }
+    field_call_.set_options(options);
+    field_call_.set_by_value(-1);
+    field_call_.hidden(calls_.empty());
+    set_dirty();
+}
+
+uint32_t MBELIBView::frames_in_selection() const {
+    if (selected_call_ < 0) {
+        return file_frames_;
+    }
+    const size_t index = static_cast<size_t>(selected_call_) - first_listed_call_;
+    return (index < calls_.size()) ? calls_[index].frame_count : 0;
+}
+
+std::filesystem::path MBELIBView::wav_path() const {
+    if (selected_call_ < 0) {
+        auto path = selected_file_;
+        path.replace_extension(".wav");
+        return path;
+    }
+    // One call decodes to NAME_callN.wav, as ambe2wav --call does
+    return selected_file_.parent_path() /
+           (selected_file_.stem().string() + "_call" + to_string_dec_uint(selected_call_ + 1) + ".wav");
+}
+
+void MBELIBView::start_session(Session session) {
+    // A batch reads this after every start, including the failed ones
+    wav_up_to_date_ = false;
     update_sd_card_state();
     if (!sd_card_available_) {
         text_status_.set("SD card not ready");
@@ -177,65 +376,295 @@ void MBELIBView::decode_selected_file() {
     }
 
     decode_abort_.store(false, std::memory_order_relaxed);
-    stop_wav_playback();
-    wav_file_ = selected_file_;
-    wav_file_.replace_extension(".wav");
-    wav_available_ = false;
+    stream_mode_ = (session != Session::DecodeToWav);
+    play_wav_ = (session == Session::PlayWav);
+    wav_file_ = wav_path();
+    decode_call_ = selected_call_;
+    decode_first_block_ = 1;
+    if (selected_call_ >= 0) {
+        decode_first_block_ = calls_[static_cast<size_t>(selected_call_) - first_listed_call_].first_block;
+    }
+    if (!stream_mode_) {
+        wav_available_ = false;
+    }
+    output_sample_rate_ = wav_sample_rate_;
+    output_format_ = wav_format_;
     update_play_button();
 
-    baseband::shutdown();
-    chThdSleepMilliseconds(20);
-    if (MBELIB_USE_PREPARED_IMAGE) {
-        baseband::run_prepared_image(portapack::memory::map::m4_code.base());
-    } else {
-        // Legacy tag for bundled image
-        baseband::run_image(portapack::spi_flash::image_tag_ambe2_decode);
+    // ADPCM blocks carry encoder state across frames, so only the
+    // stateless formats checkpoint
+    checkpoints_enabled_ = (session == Session::DecodeToWav) && (output_format_ != mbelib_audio::WavFormat::ImaAdpcm);
+    resume_ = checkpoints_enabled_ && load_checkpoint(checkpoint_);
+    if (session == Session::DecodeToWav && !resume_) {
+        DecodeManifest manifest{};
+        const auto state = read_manifest(selected_file_, wav_file_, decode_call_, manifest);
+        if (state == ManifestState::Current) {
+            wav_up_to_date_ = true;
+            text_status_.set("WAV up to date");
+            update_play_button();
+            return;
+        }
+        if (state == ManifestState::Grown && checkpoints_enabled_ && decode_call_ < 0) {
+            // Captured on since: append the new tail, as a resume from
+            // where the last decode ended
+            checkpoint_ = manifest.end;
+            resume_ = true;
+        }
+    }
+    checkpoint_saved_ = resume_;
+    if (session == Session::DecodeToWav && !resume_) {
+        // A fresh decode replaces the WAV the old sidecars described
+        remove_checkpoint();
+        ::remove(manifest_path(wav_file_).string().c_str());
+    }
+    frame_base_ = resume_ ? checkpoint_.frames_done - checkpoint_.warmup_frames : 0;
+    discard_frames_ = resume_ ? checkpoint_.warmup_frames : 0;
+    last_checkpoint_frames_ = 0;
+    frames_read_session_ = 0;
+
+    if (!baseband_kept_) {
+        baseband::shutdown();
+        chThdSleepMilliseconds(20);
+        if (MBELIB_USE_PREPARED_IMAGE) {
+            baseband::run_prepared_image(portapack::memory::map::m4_code.base());
+        } else {
+            // Legacy tag for bundled image
+            baseband::run_image(portapack::spi_flash::image_tag_ambe2_decode);
+        }
+        chThdSleepMilliseconds(10);
+    }
+    // Reset re-arms a PA2D that has already acknowledged a Stop
+    baseband_kept_ = false;
+    baseband::mbelib_decode_reset(output_sample_rate_, output_format_);
+    if (stream_mode_) {
+        // The M4 feeds the codec at 12 kHz from its jitter buffer
+        baseband::mbelib_decode_stream();
+        audio::set_rate(audio::Rate::Hz_12000);
+        audio::output::start();
+        audio::output::unmute();
+        audio::output::speaker_unmute();
+        audio::output::update_audio_mute();
     }
-    chThdSleepMilliseconds(10);
-    baseband::mbelib_decode_reset();
 
     chSysLock();
     frames_sent_ = 0;
     frames_completed_ = 0;
     total_samples_written_ = 0;
+    total_data_bytes_ = 0;
     frame_error_count_ = 0;
     decode_finalized_ = false;
+    wav_write_failed_ = false;
     decode_thread_finished_ = false;
     m4_completion_ack_received_ = false;
-    // Reset upsampling state
-    prev_sample_ = 0;
-    frame_count_ = 0;
+    // Reset upsampling state (WAV playback)
+    upsampler_.reset();
     frames_processed_latest_ = 0;
     frames_in_flight_ = 0;
     max_frames_in_flight_ = 0;
     frames_read_total_ = 0;
+    read_kib_per_second_ = 0;
     read_error_count_ = 0;
+    corrupt_block_count_ = resume_ ? checkpoint_.corrupt_blocks : 0;
     chSysUnlock();
     decode_result_ = {};
     m4_pcm_dropped_ = 0;
+    m4_frames_skipped_ = 0;
     update_m0_stats_text();
 
-    if (total_frames_expected_ == 0) {
-        File info;
-        if (!info.open(selected_file_, true, false)) {
-            const auto size = info.size();
-            info.close();
-            if (size >= sizeof(ambe_log::Header)) {
-                const auto payload = size - sizeof(ambe_log::Header);
-                total_frames_expected_ = static_cast<uint32_t>(payload / ambe_log::kFrameBytes);
-            }
-        }
+    // start_wav_playback() sets the chunk count for WAV playback
+    if (!play_wav_) {
+        // A capture that grew after it was selected reads past its count
+        const uint32_t selection = frames_in_selection();
+        total_frames_expected_ = (selection > frame_base_) ? selection - frame_base_ : 0;
     }
 
     decode_in_progress_ = true;
-    std::snprintf(decode_result_.status, sizeof(decode_result_.status), "%s", "Decoding...");
+    std::snprintf(decode_result_.status, sizeof(decode_result_.status), "%s",
+                  stream_mode_ ? "Playing..." : resume_ ? "Resuming..." : "Decoding...");
+    if (play_wav_) {
+        text_status_.set("Playing WAV...");
+    }
     update_progress_text();
-    button_decode_.set_text("Decoding...");
-    button_decode_.set_dirty();
+    if (stream_mode_) {
+        update_play_button();
+    } else {
+        button_decode_.set_text("Decoding...");
+        button_decode_.set_dirty();
+    }
 
     start_decode_thread();
 }
 
+void MBELIBView::start_batch() {
+    update_sd_card_state();
+    if (!sd_card_available_) {
+        text_status_.set("SD card not ready");
+        return;
+    }
+    if (decode_in_progress_ || decode_thread_) {
+        text_status_.set("Decode already running");
+        return;
+    }
+
+    scan_batch();
+    if (batch_queue_.empty()) {
+        text_status_.set("Batch: all decoded");
+        return;
+    }
+
+    batch_active_ = true;
+    batch_stop_ = false;
+    batch_index_ = 0;
+    batch_bytes_done_ = 0;
+    batch_frames_done_ = 0;
+    batch_done_ = 0;
+    batch_failed_ = 0;
+    batch_start_ = chTimeNow();
+    button_batch_.set_text("Stop");
+    button_batch_.set_dirty();
+    start_batch_file();
+}
+
+/* Queues the captures with no WAV, with a checkpoint left by a decode that
+ * did not finish (those resume), or whose manifest shows the capture has
+ * grown or was decoded with other settings. A WAV without a manifest is
+ * left alone. Names start with the capture time, so sorting them decodes
+ * oldest first. */
+void MBELIBView::scan_batch() {
+    const auto by_name = [](const BatchEntry& a, const BatchEntry& b) {
+        return a.path.string() < b.path.string();
+    };
+    batch_queue_.clear();
+    batch_bytes_total_ = 0;
+    for (const auto& entry : std::filesystem::directory_iterator(captures_dir, u"*.ambe")) {
+        if (!std::filesystem::is_regular_file(entry.status())) {
+            continue;
+        }
+        const auto path = captures_dir / entry.path();
+        auto wav = path;
+        wav.replace_extension(".wav");
+        auto checkpoint = path;
+        checkpoint.replace_extension(".ckpt");
+        File wav_test;
+        File checkpoint_test;
+        if (!wav_test.open(wav, true, false) && checkpoint_test.open(checkpoint, true, false)) {
+            DecodeManifest manifest{};
+            const auto state = read_manifest(path, wav, -1, manifest);
+            if (state == ManifestState::None || state == ManifestState::Current) {
+                continue;
+            }
+        }
+        batch_queue_.push_back({path, entry.size()});
+        if (batch_queue_.size() > kMaxBatchFiles) {
+            // Directory order is arbitrary: keep the oldest names, the
+            // newest wait for the next batch
+            batch_queue_.erase(std::max_element(batch_queue_.begin(), batch_queue_.end(), by_name));
+        }
+    }
+    std::sort(batch_queue_.begin(), batch_queue_.end(), by_name);
+    for (const auto& queued : batch_queue_) {
+        batch_bytes_total_ += queued.size;
+    }
+}
+
+void MBELIBView::start_batch_file() {
+    while (batch_index_ < batch_queue_.size()) {
+        const auto& entry = batch_queue_[batch_index_];
+        selected_file_ = entry.path;
+        load_file_info(selected_file_);
+        start_session(Session::DecodeToWav);
+        if (decode_in_progress_) {
+            update_batch_text();
+            return;
+        }
+        if (wav_up_to_date_) {
+            ++batch_done_;
+        } else {
+            // start_session() said why; the rest of the batch still runs
+            ++batch_failed_;
+        }
+        batch_bytes_done_ += entry.size;
+        ++batch_index_;
+    }
+    finish_batch();
+}
+
+/* Called once a batch file's decode has ended and its thread is joined;
+ * moves on to the next file unless Stop was pressed. */
+void MBELIBView::continue_batch() {
+    if (!batch_active_ || decode_in_progress_ || decode_thread_) {
+        return;
+    }
+
+    batch_bytes_done_ += batch_queue_[batch_index_].size;
+    batch_frames_done_ += frames_completed_;
+    if (decode_result_.wav_written) {
+        ++batch_done_;
+    } else if (!decode_result_.cancelled) {
+        ++batch_failed_;
+    }
+    ++batch_index_;
+    if (batch_stop_ || batch_index_ == batch_queue_.size()) {
+        finish_batch();
+        return;
+    }
+    start_batch_file();
+}
+
+void MBELIBView::finish_batch() {
+    batch_active_ = false;
+    if (baseband_kept_) {
+        baseband_kept_ = false;
+        baseband::shutdown();
+    }
+
+    char status[64];
+    std::snprintf(status, sizeof(status), "Batch %s: %lu ok, %lu failed",
+                  batch_stop_ ? "stopped" : "done",
+                  static_cast<unsigned long>(batch_done_),
+                  static_cast<unsigned long>(batch_failed_));
+    text_status_.set(status);
+    batch_queue_.clear();
+    batch_queue_.shrink_to_fit();
+    button_batch_.set_text("Batch");
+    button_batch_.set_dirty();
+    update_play_button();
+}
+
+/* File number, share of the queued bytes decoded, and speed as a multiple
+ * of real time, on the file name line. */
+void MBELIBView::update_batch_text() {
+    if (!batch_active_) {
+        return;
+    }
+
+    uint32_t completed = 0;
+    chSysLock();
+    completed = frames_completed_;
+    chSysUnlock();
+
+    const uint32_t total = total_frames_expected_;
+    uint64_t bytes = batch_bytes_done_;
+    if (total > 0) {
+        bytes += static_cast<uint64_t>(input_size_) * std::min(completed, total) / total;
+    }
+    const uint32_t percent = (batch_bytes_total_ > 0) ? static_cast<uint32_t>(bytes * 100 / batch_bytes_total_) : 0;
+    // 1 kHz system tick; 20 ms of audio per frame
+    const uint64_t elapsed_ms = chTimeNow() - batch_start_;
+    const uint64_t audio_ms = static_cast<uint64_t>(batch_frames_done_ + completed) * 20;
+    const uint32_t speed_x10 = (elapsed_ms > 0) ? static_cast<uint32_t>(audio_ms * 10 / elapsed_ms) : 0;
+
+    char line[64];
+    std::snprintf(line, sizeof(line), "%lu/%lu %lu%% %lu.%lux %s",
+                  static_cast<unsigned long>(batch_index_ + 1),
+                  static_cast<unsigned long>(batch_queue_.size()),
+                  static_cast<unsigned long>(std::min<uint32_t>(percent, 100)),
+                  static_cast<unsigned long>(speed_x10 / 10),
+                  static_cast<unsigned long>(speed_x10 % 10),
+                  selected_file_.filename().string().c_str());
+    text_selected_file_.set(line);
+}
+
 void MBELIBView::start_decode_thread() {
     if (decode_thread_) {
         return;
@@ -250,9 +679,13 @@ void MBELIBView::start_decode_thread() {
 
     if (!decode_thread_) {
         decode_in_progress_ = false;
+        if (stream_mode_) {
+            stop_stream_audio();
+        }
         text_status_.set("Thread start failed");
         button_decode_.set_text("Decode");
         button_decode_.set_dirty();
+        update_play_button();
     }
 }
 
@@ -266,7 +699,7 @@ msg_t MBELIBView::decode_thread_fn(void* arg) {
 }
 
 void MBELIBView::decode_thread() {
-    decode_result_ = read_frames_and_decode();
+    decode_result_ = play_wav_ ? read_wav_and_play() : read_frames_and_decode();
     chSysLock();
     decode_thread_finished_ = true;
     chSysUnlock();
@@ -301,52 +734,115 @@ MBELIBView::DecodeResult MBELIBView::read_frames_and_decode() {
         MutexGuard lock{file_io_mutex_};
         return input_file_.read(&header, sizeof(header));
     }();
-    if (!header_result.is_ok() || *header_result != sizeof(header) || !ambe_log::validate(header)) {
+    input_v2_ = header_result.is_ok() && ambe_log::v2::is_v2(&header, *header_result);
+    File::Offset data_start = sizeof(header);
+    skip_block_frames_ = 0;
+    if (resume_) {
+        // Back to the checkpoint's warm-up start
+        if (input_v2_) {
+            decode_first_block_ = checkpoint_.resume_block;
+            skip_block_frames_ = checkpoint_.resume_frame;
+        } else {
+            data_start += static_cast<File::Offset>(checkpoint_.resume_frame) * ambe_log::kFrameBytes;
+        }
+    }
+    if (input_v2_) {
+        // Straight to the selected call's first block, or the first one
+        const auto v2_header = std::make_unique<ambe_log::v2::FileHeader>();
+        const auto v2_result = [&]() {
+            MutexGuard lock{file_io_mutex_};
+            if (input_file_.seek(0).is_error()) {
+                return File::Result<File::Size>{static_cast<File::Size>(0)};
+            }
+            const auto read = input_file_.read(v2_header.get(), sizeof(*v2_header));
+            data_start = static_cast<File::Offset>(decode_first_block_) * ambe_log::v2::kBlockBytes;
+            if (read.is_ok() && input_file_.seek(data_start).is_error()) {
+                return File::Result<File::Size>{static_cast<File::Size>(0)};
+            }
+            return read;
+        }();
+        if (!v2_result.is_ok() || *v2_result != sizeof(*v2_header) || !ambe_log::v2::validate(*v2_header)) {
+            std::snprintf(result.status, sizeof(result.status), "%s", "Bad header");
+            close_file();
+            return result;
+        }
+        block_sequence_ = decode_first_block_;
+        block_ = {};
+        block_frame_ = 0;
+        block_last_ = false;
+        corrupt_run_ = 0;
+    } else if (!header_result.is_ok() || *header_result != sizeof(header) || !ambe_log::validate(header)) {
         std::snprintf(result.status, sizeof(result.status), "%s", "Bad header");
         close_file();
         return result;
+    } else if (data_start != sizeof(header)) {
+        const auto seek_result = [&]() {
+            MutexGuard lock{file_io_mutex_};
+            return input_file_.seek(data_start);
+        }();
+        if (seek_result.is_error()) {
+            std::snprintf(result.status, sizeof(result.status), "%s", "Seek failed");
+            close_file();
+            return result;
+        }
     }
+    read_ahead_.reset(&input_file_, &file_io_mutex_, data_start);
 
-    const auto wav_create = [&]() {
-        MutexGuard lock{file_io_mutex_};
-        return output_file_.create(wav_file_);
-    }();
-    if (wav_create) {
-        std::snprintf(result.status, sizeof(result.status), "%s", "WAV create failed");
-        close_file();
-        return result;
-    }
+    // Play .ambe only retires frames; the M4 sends the audio to the codec
+    if (resume_) {
+        // Keep the WAV up to the checkpoint and drop whatever came after it
+        const auto wav_resume = [&]() {
+            MutexGuard lock{file_io_mutex_};
+            if (output_file_.open(wav_file_, false, false)) {
+                return false;
+            }
+            const auto end = mbelib_audio::wav_header_size(output_format_) + checkpoint_.data_bytes;
+            return !output_file_.seek(end).is_error() && !output_file_.truncate();
+        }();
+        if (!wav_resume) {
+            std::snprintf(result.status, sizeof(result.status), "%s", "WAV resume failed");
+            close_output_file();
+            close_file();
+            return result;
+        }
+    } else if (!stream_mode_) {
+        const auto wav_create = [&]() {
+            MutexGuard lock{file_io_mutex_};
+            return output_file_.create(wav_file_);
+        }();
+        if (wav_create) {
+            std::snprintf(result.status, sizeof(result.status), "%s", "WAV create failed");
+            close_file();
+            return result;
+        }
 
-    if (!write_wav_header(output_file_, 0, kPlaybackSampleRate)) {
-        std::snprintf(result.status, sizeof(result.status), "%s", "Header write err");
-        close_output_file();
-        close_file();
-        auto wav_path_string = wav_file_.string();
-        ::remove(wav_path_string.c_str());
-        return result;
-    }
+        if (!write_wav_header(output_file_, 0, 0)) {
+            std::snprintf(result.status, sizeof(result.status), "%s", "Header write err");
+            close_output_file();
+            close_file();
+            remove_partial_wav();
+            return result;
+        }
 
-    const auto data_seek = [&]() {
-        MutexGuard lock{file_io_mutex_};
-        return output_file_.seek(kWavHeaderSize);
-    }();
-    if (data_seek.is_error()) {
-        std::snprintf(result.status, sizeof(result.status), "%s", "Seek failed");
-        close_output_file();
-        close_file();
-        auto wav_path_string = wav_file_.string();
-        ::remove(wav_path_string.c_str());
-        return result;
+        const auto data_seek = [&]() {
+            MutexGuard lock{file_io_mutex_};
+            return output_file_.seek(mbelib_audio::wav_header_size(output_format_));
+        }();
+        if (data_seek.is_error()) {
+            std::snprintf(result.status, sizeof(result.status), "%s", "Seek failed");
+            close_output_file();
+            close_file();
+            remove_partial_wav();
+            return result;
+        }
     }
 
     output_ready_ = true;
     chSysLock();
     frames_completed_ = 0;
-    total_samples_written_ = 0;
+    total_samples_written_ = resume_ ? checkpoint_.samples_written : 0;
+    total_data_bytes_ = resume_ ? checkpoint_.data_bytes : 0;
     frames_in_flight_ = 0;
-    // Reset upsampling state
-    prev_sample_ = 0;
-    frame_count_ = 0;
     // Reset completion acknowledgment
     m4_completion_ack_received_ = false;
     chSysUnlock();
@@ -364,10 +860,7 @@ MBELIBView::DecodeResult MBELIBView::read_frames_and_decode() {
             break;
         }
 
-        const auto read_result = [&]() {
-            MutexGuard lock{file_io_mutex_};
-            return input_file_.read(packed.data(), packed.size());
-        }();
+        const auto read_result = next_frame(packed.data());
         if (!read_result.is_ok()) {
             const auto& err = read_result.error();
             const auto msg = err.what();
@@ -380,8 +873,7 @@ MBELIBView::DecodeResult MBELIBView::read_frames_and_decode() {
             output_ready_ = false;
             close_output_file();
             close_file();
-            auto wav_path_string = wav_file_.string();
-            ::remove(wav_path_string.c_str());
+            remove_partial_wav();
             reset_inflight();
             return result;
         }
@@ -396,66 +888,62 @@ MBELIBView::DecodeResult MBELIBView::read_frames_and_decode() {
             output_ready_ = false;
             close_output_file();
             close_file();
-            auto wav_path_string = wav_file_.string();
-            ::remove(wav_path_string.c_str());
+            remove_partial_wav();
             reset_inflight();
             return result;
         }
 
-        while (true) {
-            if (decode_abort_.load(std::memory_order_relaxed)) {
-                result.cancelled = true;
-                break;
-            }
-
-            uint32_t inflight = 0;
-            chSysLock();
-            inflight = frames_in_flight_;
-            chSysUnlock();
-
-            if (inflight < kMaxInFlightFrames) {
-                break;
-            }
-
-            RequestSignalMessage throttle_update{RequestSignalMessage::Signal::AmbeDecodeHostStats};
-            EventDispatcher::send_message(throttle_update);
-            chThdSleepMilliseconds(kInflightSleepMs);
-        }
+        // For checkpoints and the manifest; v1 frames are counted from
+        // the start of the file
+        const InputPosition position{
+            input_v2_ ? block_sequence_ - 1 : 0,
+            input_v2_ ? static_cast<uint32_t>(block_frame_ - 1) : frame_base_ + frames_read_session_,
+            corrupt_block_count_};
+        chSysLock();
+        input_positions_[frames_read_session_ % kInputPositions] = position;
+        ++frames_read_session_;
+        chSysUnlock();
 
-        if (result.cancelled) {
+        // At most kMaxInFlightFrames frames wait on the baseband, so a
+        // decode runs as fast as the M4 returns them. In stream mode the M4
+        // withholds acks while its jitter buffer is full, which paces
+        // reading to playback
+        if (!wait_for_frame_slot()) {
+            result.cancelled = true;
             break;
         }
 
-        uint32_t sequence = 0;
-        chSysLock();
-        sequence = frames_sent_++;
-        ++frames_in_flight_;
-        ++frames_read_total_;
-        if (frames_in_flight_ > max_frames_in_flight_) {
-            max_frames_in_flight_ = frames_in_flight_;
-        }
-        chSysUnlock();
-        chThdSleepMilliseconds(50);
+        const uint32_t sequence = claim_frame_slot();
         baseband::mbelib_decode_send_frame(packed.data());
+        report_frame_sent(sequence);
 
-        RequestSignalMessage host_stats{RequestSignalMessage::Signal::AmbeDecodeHostStats};
-        EventDispatcher::send_message(host_stats);
-
-        if (((sequence + 1u) <= 10u) || ((sequence + 1u) % 25u) == 0u) {
-            RequestSignalMessage progress{RequestSignalMessage::Signal::AmbeDecodeProgress};
-            EventDispatcher::send_message(progress);
-        }
+        // The next chunk is read while the baseband works on this frame
+        read_ahead_.prefetch();
+        const uint32_t read_rate = read_ahead_.kib_per_second();
+        chSysLock();
+        read_kib_per_second_ = read_rate;
+        chSysUnlock();
     }
 
+    // Up to the last whole frame, or block, read. A call ends mid-file, so
+    // a call decode covers the file as it is now
+    if (!input_v2_) {
+        input_consumed_ = sizeof(ambe_log::Header) +
+                          static_cast<File::Size>(frame_base_ + frames_read_session_) * ambe_log::kFrameBytes;
+    } else if (decode_call_ < 0) {
+        input_consumed_ = static_cast<File::Size>(block_sequence_ - 1) * ambe_log::v2::kBlockBytes;
+    } else {
+        MutexGuard lock{file_io_mutex_};
+        input_consumed_ = input_file_.size();
+    }
     close_file();
 
     if (result.cancelled) {
         output_ready_ = false;
         close_output_file();
-        auto wav_path_string = wav_file_.string();
-        ::remove(wav_path_string.c_str());
+        remove_partial_wav();
         reset_inflight();
-        std::snprintf(result.status, sizeof(result.status), "%s", "Decode cancelled");
+        std::snprintf(result.status, sizeof(result.status), "%s", stream_mode_ ? "Playback stopped" : "Decode cancelled");
         return result;
     }
 
@@ -476,6 +964,195 @@ MBELIBView::DecodeResult MBELIBView::read_frames_and_decode() {
     return result;
 }
 
+/* Next packed frame from the input. v1 frames follow one another; v2 ones
+ * are unpacked from blocks, skipping index pages, up to the end of the
+ * call being decoded. A v2 block that fails its CRC, or will not read at
+ * all, is counted and skipped; decoding resumes at the next good block. */
+File::Result<File::Size> MBELIBView::next_frame(uint8_t* packed) {
+    if (!input_v2_) {
+        return read_ahead_.next(packed, ambe_log::kFrameBytes);
+    }
+
+    while (block_frame_ == block_.frame_count()) {
+        if (block_last_) {
+            return File::Result<File::Size>{static_cast<File::Size>(0)};
+        }
+        const uint32_t sequence = block_sequence_++;
+        block_frame_ = 0;
+        const auto read_result = read_ahead_.next(reinterpret_cast<uint8_t*>(&block_), sizeof(block_));
+        if (!read_result.is_ok()) {
+            // Restart reading at the next block. A bad sector later in the
+            // same 4 KB chunk fails again and costs one more block
+            block_ = {};
+            if (!count_corrupt_block()) {
+                return read_result;
+            }
+            const File::Offset offset = static_cast<File::Offset>(block_sequence_) * ambe_log::v2::kBlockBytes;
+            const auto seek_result = [&]() {
+                MutexGuard lock{file_io_mutex_};
+                return input_file_.seek(offset);
+            }();
+            if (seek_result.is_error()) {
+                return read_result;
+            }
+            read_ahead_.reset(&input_file_, &file_io_mutex_, offset);
+            continue;
+        }
+        if (*read_result != sizeof(block_)) {
+            block_ = {};
+            return File::Result<File::Size>{static_cast<File::Size>(0)};
+        }
+
+        const auto kind = ambe_log::v2::classify_block(block_, sequence);
+        const uint32_t skip = skip_block_frames_;
+        skip_block_frames_ = 0;
+        if (kind != ambe_log::v2::BlockKind::Data) {
+            block_ = {};
+            if (kind == ambe_log::v2::BlockKind::Corrupt && !count_corrupt_block()) {
+                return File::Result<File::Size>{static_cast<File::Size>(0)};
+            }
+            continue;
+        }
+        corrupt_run_ = 0;
+        if (decode_call_ >= 0 && block_.header.call_id != static_cast<uint32_t>(decode_call_)) {
+            block_ = {};
+            return File::Result<File::Size>{static_cast<File::Size>(0)};
+        }
+        block_last_ = (decode_call_ >= 0) && (block_.header.flags & ambe_log::v2::kCallEnd);
+        block_frame_ = std::min<size_t>(skip, block_.frame_count());
+    }
+
+    std::memcpy(packed, block_.frames[block_frame_++], ambe_log::kFrameBytes);
+    return File::Result<File::Size>{static_cast<File::Size>(ambe_log::kFrameBytes)};
+}
+
+/* Counts a skipped v2 block. False once kMaxCorruptRun have gone by in a
+ * row, which is taken as the end of the data. */
+bool MBELIBView::count_corrupt_block() {
+    chSysLock();
+    ++corrupt_block_count_;
+    chSysUnlock();
+    return ++corrupt_run_ < ambe_log::v2::kMaxCorruptRun;
+}
+
+MBELIBView::DecodeResult MBELIBView::read_wav_and_play() {
+    DecodeResult result{};
+    std::snprintf(result.status, sizeof(result.status), "%s", "Playback failed");
+
+    // Format was checked by start_wav_playback()
+    auto reader = std::make_unique<WAVFileReader>();
+    if (!reader->open(wav_file_)) {
+        std::snprintf(result.status, sizeof(result.status), "%s", "WAV open failed");
+        return result;
+    }
+    const bool native_rate = (reader->sample_rate() == mbelib_audio::kDecodeSampleRate);
+    output_ready_ = true;
+
+    while (true) {
+        if (!wait_for_frame_slot()) {
+            result.cancelled = true;
+            break;
+        }
+
+        // Bring one chunk to 12 kHz: 8 kHz files go through the same 6x
+        // interpolator as the decode path, then every 4th sample is kept
+        size_t count = 0;
+        if (native_rate) {
+            std::array<int16_t, kPlaybackChunkSamples * kPlaybackDecimation / mbelib_audio::kUpsampleFactor> native{};
+            const auto read_result = reader->read(native.data(), native.size() * sizeof(int16_t));
+            if (read_result.is_error()) {
+                std::snprintf(result.status, sizeof(result.status), "%s", "Playback read error");
+                break;
+            }
+            const size_t samples = *read_result / sizeof(int16_t);
+            count = upsampler_.process(native.data(), samples, playback_buffer_.data());
+        } else {
+            const auto read_result = reader->read(playback_buffer_.data(), playback_buffer_.size() * sizeof(int16_t));
+            if (read_result.is_error()) {
+                std::snprintf(result.status, sizeof(result.status), "%s", "Playback read error");
+                break;
+            }
+            count = *read_result / sizeof(int16_t);
+        }
+        if (count == 0) {
+            result.success = true;
+            break;
+        }
+
+        size_t decimated = 0;
+        for (size_t i = 0; i < count; i += kPlaybackDecimation) {
+            playback_buffer_[decimated++] = playback_buffer_[i];
+        }
+
+        const uint32_t sequence = claim_frame_slot();
+        baseband::mbelib_play_samples(playback_buffer_.data(), decimated);
+        report_frame_sent(sequence);
+    }
+
+    if (!result.success) {
+        output_ready_ = false;
+        chSysLock();
+        frames_in_flight_ = 0;
+        chSysUnlock();
+        if (result.cancelled) {
+            std::snprintf(result.status, sizeof(result.status), "%s", "Playback stopped");
+        }
+        return result;
+    }
+
+    uint32_t sent = 0;
+    chSysLock();
+    sent = frames_sent_;
+    chSysUnlock();
+    result.frames = sent;
+    std::snprintf(result.status, sizeof(result.status), "%s", "Playing...");
+    return result;
+}
+
+bool MBELIBView::wait_for_frame_slot() {
+    while (true) {
+        if (decode_abort_.load(std::memory_order_relaxed)) {
+            return false;
+        }
+
+        uint32_t inflight = 0;
+        chSysLock();
+        inflight = frames_in_flight_;
+        chSysUnlock();
+
+        if (inflight < kMaxInFlightFrames) {
+            return true;
+        }
+
+        RequestSignalMessage throttle_update{RequestSignalMessage::Signal::AmbeDecodeHostStats};
+        EventDispatcher::send_message(throttle_update);
+        chThdSleepMilliseconds(kInflightSleepMs);
+    }
+}
+
+uint32_t MBELIBView::claim_frame_slot() {
+    uint32_t sequence = 0;
+    chSysLock();
+    sequence = frames_sent_++;
+    ++frames_in_flight_;
+    ++frames_read_total_;
+    if (frames_in_flight_ > max_frames_in_flight_) {
+        max_frames_in_flight_ = frames_in_flight_;
+    }
+    chSysUnlock();
+    return sequence;
+}
+
+void MBELIBView::report_frame_sent(uint32_t sequence) {
+    RequestSignalMessage host_stats{RequestSignalMessage::Signal::AmbeDecodeHostStats};
+    EventDispatcher::send_message(host_stats);
+
+    if (((sequence + 1u) <= 10u) || ((sequence + 1u) % 25u) == 0u) {
+        RequestSignalMessage progress{RequestSignalMessage::Signal::AmbeDecodeProgress};
+        EventDispatcher::send_message(progress);
+    }
+}
+
 void MBELIBView::close_file() {
     if (file_open_) {
         MutexGuard lock{file_io_mutex_};
@@ -489,6 +1166,197 @@ void MBELIBView::close_output_file() {
     output_file_.close();
 }
 
+void MBELIBView::remove_partial_wav() {
+    // Play .ambe never opens the WAV; an existing one stays. So does one a
+    // checkpoint describes, for Decode to pick up from
+    if (stream_mode_ || checkpoint_saved_) {
+        return;
+    }
+    auto wav_path_string = wav_file_.string();
+    if (!wav_path_string.empty()) {
+        ::remove(wav_path_string.c_str());
+    }
+}
+
+std::filesystem::path MBELIBView::checkpoint_path() const {
+    auto path = wav_file_;
+    path.replace_extension(".ckpt");
+    return path;
+}
+
+bool MBELIBView::same_settings(const DecodeCheckpoint& checkpoint, int32_t call) const {
+    return checkpoint.call == call && checkpoint.sample_rate == wav_sample_rate_ &&
+           checkpoint.format == static_cast<uint8_t>(wav_format_);
+}
+
+bool MBELIBView::wav_holds(const std::filesystem::path& wav, const DecodeCheckpoint& checkpoint) const {
+    File file;
+    if (file.open(wav, true, false)) {
+        return false;
+    }
+    return file.size() >= mbelib_audio::wav_header_size(static_cast<mbelib_audio::WavFormat>(checkpoint.format)) +
+                              checkpoint.data_bytes;
+}
+
+/* A checkpoint is only used for the same input, selection and output
+ * settings, and only while its WAV still holds all the audio it counts. */
+bool MBELIBView::load_checkpoint(DecodeCheckpoint& checkpoint) {
+    File file;
+    if (file.open(checkpoint_path(), true, false)) {
+        return false;
+    }
+    const auto read = file.read(&checkpoint, sizeof(checkpoint));
+    if (!read.is_ok() || *read != sizeof(checkpoint) || checkpoint.magic != kCheckpointMagic ||
+        checkpoint.crc32 != ambe_log::v2::crc32(&checkpoint, offsetof(DecodeCheckpoint, crc32))) {
+        return false;
+    }
+    if (checkpoint.input_size != input_size_ || !same_settings(checkpoint, selected_call_) ||
+        checkpoint.frames_done < checkpoint.warmup_frames || checkpoint.frames_done >= frames_in_selection()) {
+        return false;
+    }
+    return wav_holds(wav_file_, checkpoint);
+}
+
+/* The audio written so far and where to pick up after it: up to
+ * kResumeWarmupFrames before the last written frame, taken from the
+ * positions the decode thread noted as it read. */
+bool MBELIBView::make_checkpoint(DecodeCheckpoint& checkpoint) {
+    uint32_t completed = 0;
+    uint32_t read = 0;
+    InputPosition position{};
+    checkpoint = {};
+    chSysLock();
+    completed = frames_completed_;
+    checkpoint.samples_written = total_samples_written_;
+    checkpoint.data_bytes = total_data_bytes_;
+    read = frames_read_session_;
+    const uint32_t warmup = std::min(completed, kResumeWarmupFrames);
+    const uint32_t resume_index = completed - warmup;
+    position = input_positions_[resume_index % kInputPositions];
+    chSysUnlock();
+    if (completed == 0 || read - resume_index > kInputPositions) {
+        return false;
+    }
+
+    checkpoint.magic = kCheckpointMagic;
+    checkpoint.sample_rate = output_sample_rate_;
+    checkpoint.input_size = input_size_;
+    checkpoint.call = decode_call_;
+    checkpoint.format = static_cast<uint8_t>(output_format_);
+    checkpoint.frames_done = frame_base_ + completed;
+    checkpoint.resume_block = position.block;
+    checkpoint.resume_frame = position.frame;
+    checkpoint.warmup_frames = warmup;
+    checkpoint.corrupt_blocks = position.corrupt_blocks;
+    checkpoint.crc32 = ambe_log::v2::crc32(&checkpoint, offsetof(DecodeCheckpoint, crc32));
+    return true;
+}
+
+/* Brings the WAV header up to date and syncs before the checkpoint that
+ * counts on it is written. */
+void MBELIBView::save_checkpoint() {
+    DecodeCheckpoint checkpoint{};
+    if (!make_checkpoint(checkpoint)) {
+        return;
+    }
+
+    const auto sync_wav = [&]() {
+        MutexGuard lock{file_io_mutex_};
+        return !output_file_.sync().is_valid();
+    };
+    bool wav_ok = sync_wav() && write_wav_header(output_file_, checkpoint.samples_written, checkpoint.data_bytes);
+    if (wav_ok) {
+        const auto data_seek = [&]() {
+            MutexGuard lock{file_io_mutex_};
+            return output_file_.seek(mbelib_audio::wav_header_size(output_format_) + checkpoint.data_bytes);
+        }();
+        wav_ok = !data_seek.is_error() && sync_wav();
+    }
+    if (!wav_ok) {
+        // The last good checkpoint, if any, still matches the WAV
+        text_status_.set("WAV sync err");
+        decode_abort_ = true;
+        return;
+    }
+
+    MutexGuard lock{file_io_mutex_};
+    File file;
+    if (file.create(checkpoint_path())) {
+        return;
+    }
+    if (!file.write(&checkpoint, sizeof(checkpoint)).is_error() && !file.sync().is_valid()) {
+        checkpoint_saved_ = true;
+    }
+}
+
+void MBELIBView::remove_checkpoint() {
+    checkpoint_saved_ = false;
+    ::remove(checkpoint_path().string().c_str());
+}
+
+/* Current when the input still has the size and CRCs the manifest
+ * recorded and the settings match; Grown when those CRCs still match a
+ * longer input. Either way the WAV must still hold the audio counted. */
+MBELIBView::ManifestState MBELIBView::read_manifest(const std::filesystem::path& input,
+                                                    const std::filesystem::path& wav,
+                                                    int32_t call,
+                                                    DecodeManifest& manifest) const {
+    File file;
+    if (file.open(manifest_path(wav), true, false)) {
+        return ManifestState::None;
+    }
+    const auto read = file.read(&manifest, sizeof(manifest));
+    if (!read.is_ok() || *read != sizeof(manifest) || manifest.magic != kManifestMagic ||
+        manifest.crc32 != ambe_log::v2::crc32(&manifest, offsetof(DecodeManifest, crc32))) {
+        return ManifestState::None;
+    }
+
+    File source;
+    if (source.open(input, true, false)) {
+        return ManifestState::None;
+    }
+    const auto size = source.size();
+    uint32_t head = 0;
+    uint32_t tail = 0;
+    if (size < manifest.end.input_size || !input_fingerprint(source, manifest.end.input_size, head, tail) ||
+        head != manifest.head_crc || tail != manifest.tail_crc || !wav_holds(wav, manifest.end)) {
+        return ManifestState::None;
+    }
+    if (manifest.decoder_version != mbelib_audio::kDecoderVersion || !same_settings(manifest.end, call)) {
+        return ManifestState::Stale;
+    }
+    return (size == manifest.end.input_size) ? ManifestState::Current : ManifestState::Grown;
+}
+
+/* Written once the WAV is final; without one the next Decode starts over. */
+void MBELIBView::save_manifest() {
+    DecodeManifest manifest{};
+    File source;
+    if (!make_checkpoint(manifest.end) || source.open(selected_file_, true, false) ||
+        !input_fingerprint(source, input_consumed_, manifest.head_crc, manifest.tail_crc)) {
+        return;
+    }
+    manifest.end.input_size = input_consumed_;
+    manifest.end.crc32 = ambe_log::v2::crc32(&manifest.end, offsetof(DecodeCheckpoint, crc32));
+    manifest.magic = kManifestMagic;
+    manifest.decoder_version = mbelib_audio::kDecoderVersion;
+    manifest.crc32 = ambe_log::v2::crc32(&manifest, offsetof(DecodeManifest, crc32));
+
+    File file;
+    if (file.create(manifest_path(wav_file_))) {
+        return;
+    }
+    if (file.write(&manifest, sizeof(manifest)).is_error() || file.sync().is_valid()) {
+        file.close();
+        ::remove(manifest_path(wav_file_).string().c_str());
+    }
+}
+
+void MBELIBView::stop_stream_audio() {
+    audio::output::stop();
+    audio::output::speaker_mute();
+}
+
 
 void MBELIBView::handle_decode_complete() {
     if (decode_thread_) {
@@ -496,25 +1364,34 @@ void MBELIBView::handle_decode_complete() {
         decode_thread_ = nullptr;
     }
 
+    if (wav_write_failed_) {
+        // Aborted by write_wav_data(): a failure, not a cancel
+        decode_result_.success = false;
+        decode_result_.cancelled = false;
+        std::snprintf(decode_result_.status, sizeof(decode_result_.status), "%s", "WAV write err");
+    }
+
     if (!decode_result_.success) {
         decode_in_progress_ = false;
         output_ready_ = false;
         close_output_file();
         text_status_.set(decode_result_.status);
-        auto wav_path_string = wav_file_.string();
-        if (!wav_path_string.empty()) {
-            ::remove(wav_path_string.c_str());
+        remove_partial_wav();
+        if (stream_mode_) {
+            stop_stream_audio();
         }
         button_decode_.set_text("Decode");
         button_decode_.set_dirty();
         update_play_button();
         baseband::shutdown();
         update_m0_stats_text();
+        continue_batch();
         return;
     }
 
     update_progress_text();
     finalize_decode_if_ready();
+    continue_batch();
 }
 
 bool MBELIBView::wav_exists() const {
@@ -534,10 +1411,18 @@ bool MBELIBView::wav_exists() const {
 void MBELIBView::update_play_button() {
     const bool wav_present = wav_exists();
     wav_available_ = wav_present && !decode_in_progress_;
-    const bool show = sd_card_available_ && wav_present && !decode_in_progress_;
+    const bool show = sd_card_available_ && wav_present && (!decode_in_progress_ || play_wav_);
     button_play_wav_.hidden(!show);
-    button_play_wav_.set_text(is_playing_ ? "Stop" : "Play WAV");
+    button_play_wav_.set_text(wav_playing() ? "Stop" : "Play WAV");
     button_play_wav_.set_dirty();
+    const bool playing_ambe = decode_in_progress_ && stream_mode_ && !play_wav_;
+    button_play_ambe_.hidden(!sd_card_available_ || (decode_in_progress_ && !playing_ambe));
+    button_play_ambe_.set_text(playing_ambe ? "Stop" : "Play AMBE");
+    button_play_ambe_.set_dirty();
+}
+
+bool MBELIBView::wav_playing() const {
+    return decode_in_progress_ && play_wav_;
 }
 
 void MBELIBView::start_wav_playback() {
@@ -546,10 +1431,6 @@ void MBELIBView::start_wav_playback() {
         return;
     }
 
-    if (is_playing_) {
-        return;
-    }
-
     if (!sd_card_available_) {
         text_status_.set("SD card not ready");
         return;
@@ -561,106 +1442,52 @@ void MBELIBView::start_wav_playback() {
         return;
     }
 
-    auto reader = std::make_unique<WAVFileReader>();
-    if (!reader->open(wav_file_)) {
+    // Playback streams PCM only
+    if (!wav_is_pcm()) {
+        text_status_.set("Play needs a PCM WAV");
+        return;
+    }
+
+    WAVFileReader reader{};
+    if (!reader.open(wav_file_)) {
         text_status_.set("WAV open failed");
         return;
     }
 
-    if ((reader->channels() != 1) ||
-        !((reader->bits_per_sample() == 8) || (reader->bits_per_sample() == 16))) {
+    // The rates the decoder writes; both map onto the 12 kHz codec rate
+    const uint32_t sample_rate = reader.sample_rate();
+    if ((reader.channels() != 1) || (reader.bits_per_sample() != 16) ||
+        ((sample_rate != mbelib_audio::kDecodeSampleRate) && (sample_rate != mbelib_audio::kPlaybackSampleRate))) {
         text_status_.set("Unsupported WAV format");
         return;
     }
 
-    baseband::shutdown();
-    chThdSleepMilliseconds(20);
-    baseband::run_image(portapack::spi_flash::image_tag_audio_tx);
-    chThdSleepMilliseconds(10);
-
-    if (replay_thread_) {
-        replay_thread_.reset();
-    }
-
-    const uint32_t sample_rate = reader->sample_rate();
-    const uint16_t bits_per_sample = reader->bits_per_sample();
-
-    baseband::set_audiotx_config(
-        1536000 / 20,
-        portapack::transmitter_model.channel_bandwidth(),
-        0,
-        8,
-        bits_per_sample,
-        0,
-        false, false, false, false);
-
-    baseband::set_sample_rate(sample_rate);
-    portapack::transmitter_model.set_sampling_rate(1536000);
-
-    portapack::transmitter_model.enable();
-
-    ready_signal_ = false;
-    replay_thread_ = std::make_unique<ReplayThread>(
-        std::move(reader),
-        2048,
-        3,
-        &ready_signal_,
-        [](uint32_t return_code) {
-            ReplayThreadDoneMessage message{return_code};
-            EventDispatcher::send_message(message);
-        });
-
-    const audio::Rate codec_rate =
-        (sample_rate <= 12000)
-            ? audio::Rate::Hz_12000
-            : (sample_rate <= 24000) ? audio::Rate::Hz_24000 : audio::Rate::Hz_48000;
-    audio::set_rate(codec_rate);
-
-    audio::output::start();
-    audio::output::unmute();
-    audio::output::speaker_unmute();
-    audio::output::update_audio_mute();
-
-    is_playing_ = true;
-    text_status_.set("Streaming WAV...");
-    update_play_button();
+    total_frames_expected_ = reader.ms_duration() / kPlaybackChunkMs;
+    start_session(Session::PlayWav);
 }
 
 void MBELIBView::stop_wav_playback() {
-    if (!is_playing_ && !replay_thread_) {
-        return;
+    if (wav_playing()) {
+        decode_abort_ = true;
     }
+}
 
-    if (replay_thread_) {
-        replay_thread_.reset();
+void MBELIBView::on_pcm_frame(const AMBEPCMFrameMessage&) {
+    // Stream mode: the M4 plays the audio itself and its empty frames only
+    // retire in-flight slots
+    if (!decode_in_progress_ || decode_finalized_ || !output_ready_ || !stream_mode_) {
+        return;
     }
 
-    audio::output::stop();
-    audio::output::speaker_mute();
-    portapack::transmitter_model.disable();
-    baseband::shutdown();
-    ready_signal_ = false;
-    is_playing_ = false;
-    update_play_button();
-}
-
-void MBELIBView::on_replay_done(uint32_t return_code) {
-    stop_wav_playback();
-    switch (return_code) {
-        case ReplayThread::END_OF_FILE:
-            text_status_.set("Playback complete");
-            break;
-        case ReplayThread::READ_ERROR:
-            text_status_.set("Playback read error");
-            break;
-        default:
-            text_status_.set("Playback stopped");
-            break;
+    if (decode_abort_.load(std::memory_order_relaxed)) {
+        return;
     }
+
+    retire_frame(0, 0);
 }
 
-void MBELIBView::on_pcm_frame(const AMBEPCMFrameMessage& message) {
-    if (!decode_in_progress_ || decode_finalized_ || !output_ready_) {
+void MBELIBView::on_wav_data(const AMBEWavDataMessage& message) {
+    if (!decode_in_progress_ || decode_finalized_ || !output_ready_ || stream_mode_) {
         return;
     }
 
@@ -668,46 +1495,35 @@ void MBELIBView::on_pcm_frame(const AMBEPCMFrameMessage& message) {
         return;
     }
 
-    const size_t sample_count = message.sample_count;
-
-    // Upsample and smooth the AGC-processed int16_t data from M4 (6x to 48kHz)
-    std::array<int16_t, 960> upsampled_buffer{};
-    size_t upsampled_count = 0;
-    upsample_and_smooth(message.samples, sample_count, upsampled_buffer.data(), &upsampled_count);
-
-    // Apply final clamping to -32768 to +32767 range (dsd.test style)
-    for (size_t i = 0; i < upsampled_count; ++i) {
-        if (upsampled_buffer[i] > 32767) upsampled_buffer[i] = 32767;
-        if (upsampled_buffer[i] < -32768) upsampled_buffer[i] = -32768;
+    if (discard_frames_ > 0 && message.frame) {
+        // Resume warm-up: this audio is already in the WAV
+        --discard_frames_;
+        retire_frame(0, 0);
+        return;
     }
 
-    // Write the upsampled and smoothed data to WAV
-    const size_t byte_count = upsampled_count * sizeof(int16_t);
-    const auto write_result = [&]() {
-        MutexGuard lock{file_io_mutex_};
-        return output_file_.write(upsampled_buffer.data(), byte_count);
-    }();
+    // The M4 has already upsampled and encoded; the data is written from
+    // its buffer as is
+    if (!write_wav_data(message.data, message.byte_count)) {
+        return;
+    }
 
-    if (write_result.is_error()) {
-        output_ready_ = false;
-        decode_in_progress_ = false;
-        decode_finalized_ = true;
-        text_status_.set("WAV write err");
-        close_output_file();
-        auto wav_path_string = wav_file_.string();
-        if (!wav_path_string.empty()) {
-            ::remove(wav_path_string.c_str());
-        }
-        button_decode_.set_text("Decode");
-        button_decode_.set_dirty();
-        update_play_button();
-        baseband::shutdown();
+    if (!message.frame) {
+        // ADPCM tail, sent just before the completion ack
+        chSysLock();
+        total_data_bytes_ += message.byte_count;
+        chSysUnlock();
         return;
     }
 
+    retire_frame(message.sample_count, message.byte_count);
+}
+
+void MBELIBView::retire_frame(size_t sample_count, size_t byte_count) {
     bool trigger_update = false;
     chSysLock();
-    total_samples_written_ += upsampled_count;  // Count upsampled samples, not original
+    total_samples_written_ += sample_count;  // Samples at the WAV rate
+    total_data_bytes_ += byte_count;
     ++frames_completed_;
     if (frames_in_flight_ > 0) {
         --frames_in_flight_;
@@ -725,9 +1541,33 @@ void MBELIBView::on_pcm_frame(const AMBEPCMFrameMessage& message) {
         update_progress_text();
     }
 
+    if (checkpoints_enabled_ && output_ready_ && (local_completed - last_checkpoint_frames_) >= kCheckpointFrames) {
+        last_checkpoint_frames_ = local_completed;
+        save_checkpoint();
+    }
+
     finalize_decode_if_ready();
 }
 
+bool MBELIBView::write_wav_data(const uint8_t* data, size_t byte_count) {
+    const auto write_result = [&]() {
+        MutexGuard lock{file_io_mutex_};
+        return output_file_.write(data, byte_count);
+    }();
+
+    if (write_result.is_error()) {
+        // The decode thread stops at its next frame; handle_decode_complete()
+        // or finalize_decode_if_ready() then tears down and moves a batch on
+        output_ready_ = false;
+        wav_write_failed_ = true;
+        decode_abort_ = true;
+        text_status_.set("WAV write err");
+        return false;
+    }
+
+    return true;
+}
+
 void MBELIBView::on_decode_stats(const AMBE2DecodeStatsMessage& message) {
     if (!decode_in_progress_ || decode_finalized_) {
         return;
@@ -740,6 +1580,7 @@ void MBELIBView::on_decode_stats(const AMBE2DecodeStatsMessage& message) {
 
     frame_error_count_ = message.errors;
     m4_pcm_dropped_ = message.pcm_drop;
+    m4_frames_skipped_ = message.skipped;
 
     chSysLock();
     if (message.frames > frames_processed_latest_) {
@@ -774,8 +1615,34 @@ void MBELIBView::finalize_decode_if_ready() {
     decode_in_progress_ = false;
     output_ready_ = false;
 
-    bool wav_ok = true;
-    if (!write_wav_header(output_file_, total_samples_written_, kPlaybackSampleRate)) {
+    if (stream_mode_) {
+        // The M4 acknowledges Stop only after its jitter buffer has drained
+        stop_stream_audio();
+        baseband::shutdown();
+        decode_result_.frames = frames_completed_;
+        if (play_wav_) {
+            std::snprintf(decode_result_.status, sizeof(decode_result_.status), "Playback complete, %lu gaps",
+                          static_cast<unsigned long>(m4_pcm_dropped_));
+        } else {
+            std::snprintf(decode_result_.status, sizeof(decode_result_.status), "Played %lu frames, %lu gaps",
+                          static_cast<unsigned long>(frames_completed_),
+                          static_cast<unsigned long>(m4_pcm_dropped_));
+            if (corrupt_block_count_ > 0) {
+                const size_t len = std::strlen(decode_result_.status);
+                std::snprintf(decode_result_.status + len, sizeof(decode_result_.status) - len, ", %lu bad",
+                              static_cast<unsigned long>(corrupt_block_count_));
+            }
+        }
+        text_status_.set(decode_result_.status);
+        button_decode_.set_text("Decode");
+        button_decode_.set_dirty();
+        update_play_button();
+        return;
+    }
+
+    // The M4 sent the last ADPCM block ahead of its completion ack
+    bool wav_ok = !wav_write_failed_;
+    if (!wav_ok || !write_wav_header(output_file_, total_samples_written_, total_data_bytes_)) {
         wav_ok = false;
     } else {
         const auto sync = [&]() {
@@ -788,13 +1655,24 @@ void MBELIBView::finalize_decode_if_ready() {
     }
 
     close_output_file();
-    baseband::shutdown();
+    if (batch_active_ && !batch_stop_ && (batch_index_ + 1) < batch_queue_.size()) {
+        baseband_kept_ = true;
+    } else {
+        baseband::shutdown();
+    }
 
     if (wav_ok) {
+        remove_checkpoint();
+        save_manifest();
         decode_result_.wav_written = true;
-        decode_result_.frames = frames_completed_;
+        decode_result_.frames = frame_base_ + frames_completed_;
         decode_result_.samples = total_samples_written_;
-        if (frame_error_count_ > 0) {
+        if (corrupt_block_count_ > 0) {
+            // Audio from the skipped blocks is missing, not silent
+            std::snprintf(decode_result_.status, sizeof(decode_result_.status), "WAV saved, %lu bad blocks",
+                          static_cast<unsigned long>(corrupt_block_count_));
+            text_status_.set(decode_result_.status);
+        } else if (frame_error_count_ > 0) {
             text_status_.set("WAV saved (with errors)");
             std::snprintf(decode_result_.status, sizeof(decode_result_.status), "WAV saved (%lu errs)",
                           static_cast<unsigned long>(frame_error_count_));
@@ -808,11 +1686,8 @@ void MBELIBView::finalize_decode_if_ready() {
     } else {
         decode_result_.wav_written = false;
         wav_available_ = false;
-        text_status_.set("WAV finalize err");
-        auto wav_path_string = wav_file_.string();
-        if (!wav_path_string.empty()) {
-            ::remove(wav_path_string.c_str());
-        }
+        text_status_.set(wav_write_failed_ ? "WAV write err" : "WAV finalize err");
+        remove_partial_wav();
     }
 
     button_decode_.set_text("Decode");
@@ -820,6 +1695,7 @@ void MBELIBView::finalize_decode_if_ready() {
     update_play_button();
     // Skip update_m0_stats_text() to avoid potential stack issues
     // update_m0_stats_text();
+    continue_batch();
 }
 
 void MBELIBView::update_progress_text() {
@@ -833,8 +1709,11 @@ void MBELIBView::update_progress_text() {
     uint32_t total_expected = total_frames_expected_;
     uint32_t error_count = frame_error_count_;
     uint32_t pcm_drop = m4_pcm_dropped_;
+    uint32_t skipped = m4_frames_skipped_;
+    uint32_t corrupt = 0;
     chSysLock();
     sent = frames_sent_;
+    corrupt = corrupt_block_count_;
     completed = frames_completed_;
     processed_latest = frames_processed_latest_;
     chSysUnlock();
@@ -863,8 +1742,25 @@ void MBELIBView::update_progress_text() {
             len += appended;
         }
     }
+    if ((len > 0) && (skipped > 0) && (static_cast<size_t>(len) < sizeof(status))) {
+        const size_t remaining = sizeof(status) - static_cast<size_t>(len);
+        const int appended = std::snprintf(status + len, remaining, " skip %lu",
+                                           static_cast<unsigned long>(skipped));
+        if (appended > 0) {
+            len += appended;
+        }
+    }
+    if ((len > 0) && (corrupt > 0) && (static_cast<size_t>(len) < sizeof(status))) {
+        const size_t remaining = sizeof(status) - static_cast<size_t>(len);
+        const int appended = std::snprintf(status + len, remaining, " bad %lu",
+                                           static_cast<unsigned long>(corrupt));
+        if (appended > 0) {
+            len += appended;
+        }
+    }
 
     text_status_.set(status);
+    update_batch_text();
 }
 
 void MBELIBView::update_m0_stats_text() {
@@ -874,6 +1770,7 @@ void MBELIBView::update_m0_stats_text() {
     uint32_t max_in_flight = 0;
     uint32_t read_total = 0;
     uint32_t read_errors = 0;
+    uint32_t read_rate = 0;
 
     chSysLock();
     sent = frames_sent_;
@@ -882,6 +1779,7 @@ void MBELIBView::update_m0_stats_text() {
     max_in_flight = max_frames_in_flight_;
     read_total = frames_read_total_;
     read_errors = read_error_count_;
+    read_rate = read_kib_per_second_;
     chSysUnlock();
 
     const uint32_t pending = in_flight;
@@ -900,6 +1798,11 @@ void MBELIBView::update_m0_stats_text() {
                   //static_cast<unsigned long>(max_in_flight),
                   //static_cast<unsigned long>(read_total),
                   //static_cast<unsigned long>(read_errors));
+    if (read_rate > 0) {
+        // Rate of the SD reads themselves, not of the decode
+        const size_t len = std::strlen(line);
+        std::snprintf(line + len, sizeof(line) - len, " rd%luK/s", static_cast<unsigned long>(read_rate));
+    }
     text_m0_stats_.set(line);
 }
 
@@ -923,100 +1826,19 @@ void MBELIBView::update_ready_status() {
     }
 }
 
-void MBELIBView::upsample_and_smooth(const int16_t* input, size_t input_count, int16_t* output, size_t* output_count) {
-    if (!input || !output || !output_count || input_count == 0) {
-        *output_count = 0;
-        return;
-    }
-
-    size_t out_idx = 0;
-
-    // Triangle interpolation upsampling (6x) - matches dsd.test
-    for (size_t i = 0; i < input_count; ++i) {
-        const int16_t current_sample = input[i];
-        const int16_t prev_sample = (i == 0 && frame_count_ == 0) ? current_sample : prev_sample_;
-
-        // Generate 6 interpolated samples using triangle interpolation
-        // Convert back to float for interpolation, then back to int16
-        const float curr_f = static_cast<float>(current_sample);
-        const float prev_f = static_cast<float>(prev_sample);
-
-        output[out_idx++] = static_cast<int16_t>((curr_f * 0.166f) + (prev_f * 0.834f));
-        output[out_idx++] = static_cast<int16_t>((curr_f * 0.332f) + (prev_f * 0.668f));
-        output[out_idx++] = static_cast<int16_t>((curr_f * 0.5f) + (prev_f * 0.5f));
-        output[out_idx++] = static_cast<int16_t>((curr_f * 0.668f) + (prev_f * 0.332f));
-        output[out_idx++] = static_cast<int16_t>((curr_f * 0.834f) + (prev_f * 0.166f));
-        output[out_idx++] = current_sample;
-
-        prev_sample_ = current_sample;
-    }
-
-    // Apply temporal smoothing (5-point moving average) after enough frames
-    if (frame_count_ > 0 && out_idx >= 24) {
-        for (size_t i = 12; i < out_idx - 12; ++i) {
-            // Convert to int32 for averaging to avoid overflow
-            const int32_t sum = static_cast<int32_t>(output[i-2]) +
-                               static_cast<int32_t>(output[i-1]) +
-                               static_cast<int32_t>(output[i]) +
-                               static_cast<int32_t>(output[i+1]) +
-                               static_cast<int32_t>(output[i+2]);
-            output[i] = static_cast<int16_t>(sum / 5);
-        }
-    }
-
-    *output_count = out_idx;
-    frame_count_++;
-}
-
-bool MBELIBView::write_wav_header(File& wav_file, uint32_t sample_count, uint32_t sample_rate) {
+bool MBELIBView::write_wav_header(File& wav_file, uint32_t sample_count, uint32_t data_bytes) {
     MutexGuard lock{file_io_mutex_};
 
-    const uint16_t channels = 1;
-    const uint16_t bits_per_sample = 16;
-    const uint32_t byte_rate = sample_rate * channels * bits_per_sample / 8;
-    const uint16_t block_align = channels * bits_per_sample / 8;
-    const uint32_t data_chunk_size = sample_count * block_align;
-    const uint32_t riff_chunk_size = 36 + data_chunk_size;
-
-    struct WAVHeader {
-        char riff_id[4];
-        uint32_t chunk_size;
-        char wave_id[4];
-        char fmt_id[4];
-        uint32_t fmt_size;
-        uint16_t audio_format;
-        uint16_t num_channels;
-        uint32_t sample_rate;
-        uint32_t byte_rate;
-        uint16_t block_align;
-        uint16_t bits_per_sample;
-        char data_id[4];
-        uint32_t data_size;
-    } __attribute__((packed));
-
-    WAVHeader header{
-        {'R', 'I', 'F', 'F'},
-        riff_chunk_size,
-        {'W', 'A', 'V', 'E'},
-        {'f', 'm', 't', ' '},
-        16,
-        1,
-        channels,
-        sample_rate,
-        byte_rate,
-        block_align,
-        bits_per_sample,
-        {'d', 'a', 't', 'a'},
-        data_chunk_size};
-
-    static_assert(sizeof(WAVHeader) == kWavHeaderSize, "Unexpected WAV header size");
+    std::array<uint8_t, mbelib_audio::kMaxWavHeaderSize> header{};
+    const size_t header_size = mbelib_audio::make_wav_header(
+        output_format_, output_sample_rate_, sample_count, data_bytes, header.data());
 
     auto seek_result = wav_file.seek(0);
     if (seek_result.is_error()) {
         return false;
     }
 
-    auto write_result = wav_file.write(&header, sizeof(header));
+    auto write_result = wav_file.write(header.data(), header_size);
     if (write_result.is_error()) {
         return false;
     }
@@ -1024,4 +1846,18 @@ bool MBELIBView::write_wav_header(File& wav_file, uint32_t sample_count, uint32_
     return true;
 }
 
+bool MBELIBView::wav_is_pcm() const {
+    // wFormatTag sits at offset 20 in every WAV this app writes
+    File wav;
+    if (wav.open(wav_file_, true, false)) {
+        return false;
+    }
+    uint8_t format_tag[2]{};
+    if (wav.seek(20).is_error()) {
+        return false;
+    }
+    const auto read = wav.read(format_tag, sizeof(format_tag));
+    return read.is_ok() && (*read == sizeof(format_tag)) && (format_tag[0] == 1) && (format_tag[1] == 0);
+}
+
 }  // namespace ui
@@ -14,12 +14,16 @@
 #include "baseband_api.hpp"
 #include "message.hpp"
 #include "file.hpp"
-#include "replay_thread.hpp"
 #include "io_wave.hpp"
+#include "apps/ambe_log_v2.hpp"
+#include "apps/ambe_read_ahead.hpp"
+#include "apps/mbelib_audio.hpp"
 
+#include <array>
 #include <atomic>
 #include <memory>
 #include <string>
+#include <vector>
 
 namespace ui {
 
@@ -37,9 +41,44 @@ class MBELIBView : public View {
     void focus() override;
 
    private:
+    // One 10 ms WAV playback chunk at 48 kHz
+    static constexpr size_t kPlaybackBufferSamples = mbelib_audio::kPlaybackSampleRate / 100;
+
+    // Calls offered by field_call_; older ones still play under "All calls"
+    static constexpr size_t kMaxListedCalls = 64;
+
+    // Captures one batch run will queue
+    static constexpr size_t kMaxBatchFiles = 256;
+
     void update_sd_card_state();
     void select_file();
-    void decode_selected_file();
+    void load_file_info(const std::filesystem::path& path);
+    void load_call_index(File& file, const ambe_log::v2::FileHeader& header, File::Size size);
+    void update_call_options();
+    uint32_t frames_in_selection() const;
+    std::filesystem::path wav_path() const;
+    // What a run of the PA2D baseband does; all but DecodeToWav play
+    // through its audio output
+    enum class Session : uint8_t {
+        DecodeToWav = 0,  // .ambe to a WAV on the SD card
+        PlayAmbe,         // .ambe to the speaker
+        PlayWav           // WAV to the speaker
+    };
+
+    void start_session(Session session);
+
+    // Batch: every capture in captures_dir still needing a WAV, decoded
+    // back to back with PA2D left loaded between files
+    struct BatchEntry {
+        std::filesystem::path path;
+        File::Size size;
+    };
+    void start_batch();
+    void scan_batch();
+    void start_batch_file();
+    void continue_batch();
+    void finish_batch();
+    void update_batch_text();
     void start_decode_thread();
     static msg_t decode_thread_fn(void* arg);
     void decode_thread();
@@ -52,28 +91,96 @@ class MBELIBView : public View {
         char status[64];
     };
     DecodeResult read_frames_and_decode();
+    File::Result<File::Size> next_frame(uint8_t* packed);
+    bool count_corrupt_block();
+
+    // NAME.ckpt next to the WAV: how far an interrupted Decode got. The
+    // WAV holds exactly samples_written / data_bytes up to it, under a
+    // header that says so; the input is re-read from warmup_frames
+    // before frames_done so the decoder and AGC settle before output
+    // resumes.
+    struct DecodeCheckpoint {
+        uint32_t magic;
+        uint32_t sample_rate;
+        uint64_t input_size;
+        int32_t call;
+        uint8_t format;
+        uint8_t reserved[3];
+        uint32_t frames_done;  // Frames of the selection whose audio is in the WAV
+        uint32_t samples_written;
+        uint32_t data_bytes;
+        uint32_t resume_block;  // v2 block, 0 for v1
+        uint32_t resume_frame;  // Frame in that block, or in the v1 file
+        uint32_t warmup_frames;
+        uint32_t corrupt_blocks;  // Skipped before resume_block
+        uint32_t crc32;
+    };
+    // Where a frame came from, for a checkpoint that resumes at it
+    struct InputPosition {
+        uint32_t block;
+        uint32_t frame;
+        uint32_t corrupt_blocks;
+    };
+    static constexpr size_t kInputPositions = 64;
+
+    // NAME.manifest next to a finished WAV: what it was decoded from and
+    // how. Decode skips an input that has not changed since, and one that
+    // has only grown gets its new tail appended.
+    struct DecodeManifest {
+        uint32_t magic;
+        uint32_t decoder_version;  // mbelib_audio::kDecoderVersion
+        uint32_t head_crc;         // Fixed part of the input header
+        uint32_t tail_crc;         // Up to 4 KB of input ending at end.input_size
+        DecodeCheckpoint end;      // input_size is how much of the input was decoded
+        uint32_t crc32;
+    };
+    enum class ManifestState : uint8_t {
+        None = 0,  // No usable manifest, or the input is not what it describes
+        Current,   // WAV matches the input and settings
+        Grown,     // Input has been appended to since
+        Stale      // Other settings or decoder version
+    };
+
+    std::filesystem::path checkpoint_path() const;
+    bool same_settings(const DecodeCheckpoint& checkpoint, int32_t call) const;
+    bool wav_holds(const std::filesystem::path& wav, const DecodeCheckpoint& checkpoint) const;
+    bool load_checkpoint(DecodeCheckpoint& checkpoint);
+    bool make_checkpoint(DecodeCheckpoint& checkpoint);
+    void save_checkpoint();
+    void remove_checkpoint();
+    ManifestState read_manifest(const std::filesystem::path& input, const std::filesystem::path& wav, int32_t call,
+                                DecodeManifest& manifest) const;
+    void save_manifest();
+
+    DecodeResult read_wav_and_play();
+    bool wait_for_frame_slot();
+    uint32_t claim_frame_slot();
+    void report_frame_sent(uint32_t sequence);
     void handle_decode_complete();
     void close_file();
     void update_play_button();
     bool wav_exists() const;
     void start_wav_playback();
     void stop_wav_playback();
-    void on_replay_done(uint32_t return_code);
-    bool write_wav_header(File& wav_file, uint32_t sample_count, uint32_t sample_rate);
+    bool wav_playing() const;
+    bool write_wav_header(File& wav_file, uint32_t sample_count, uint32_t data_bytes);
+    bool wav_is_pcm() const;
     void on_pcm_frame(const AMBEPCMFrameMessage& message);
+    void on_wav_data(const AMBEWavDataMessage& message);
+    void retire_frame(size_t sample_count, size_t byte_count);
+    bool write_wav_data(const uint8_t* data, size_t byte_count);
     void on_decode_stats(const AMBE2DecodeStatsMessage& message);
     void finalize_decode_if_ready();
     void update_progress_text();
     void update_ready_status();
     void update_m0_stats_text();
     void close_output_file();
-    void upsample_and_smooth(const int16_t* input, size_t input_count, int16_t* output, size_t* output_count);
+    void remove_partial_wav();
+    void stop_stream_audio();
 
     NavigationView& nav_;
 
-    // Upsampling state
-    int16_t prev_sample_{0};
-    size_t frame_count_{0};
+    mbelib_audio::Upsampler upsampler_{};
 
     Text text_m0_stats_{
         {2 * 8, 1 * 16, UI_POS_WIDTH_REMAINING(4), 16},
@@ -99,6 +206,37 @@ class MBELIBView : public View {
         {2 * 8, 6 * 16, 10 * 8, 16},
         "Play WAV"};
 
+    // Decodes straight to the speaker; nothing is written to the SD card
+    Button button_play_ambe_{
+        {2 * 8, 7 * 16, 10 * 8, 16},
+        "Play AMBE"};
+
+    Button button_batch_{
+        {2 * 8, 8 * 16, 10 * 8, 16},
+        "Batch"};
+
+    // 8 kHz stores the vocoder output as is (6x smaller WAV, less SD I/O);
+    // playback resamples either rate on the fly
+    OptionsField field_wav_rate_{
+        {14 * 8, 6 * 16},
+        7,
+        {{"WAV 48k", static_cast<int32_t>(mbelib_audio::kPlaybackSampleRate)},
+         {"WAV 8k", static_cast<int32_t>(mbelib_audio::kDecodeSampleRate)}}};
+
+    // uLaw halves and IMA ADPCM quarters the WAV size again
+    OptionsField field_wav_codec_{
+        {22 * 8, 6 * 16},
+        5,
+        {{"PCM", static_cast<int32_t>(mbelib_audio::WavFormat::Pcm16)},
+         {"uLaw", static_cast<int32_t>(mbelib_audio::WavFormat::MuLaw)},
+         {"ADPCM", static_cast<int32_t>(mbelib_audio::WavFormat::ImaAdpcm)}}};
+
+    // v2 captures only: decode one call instead of the whole file
+    OptionsField field_call_{
+        {2 * 8, 4 * 16},
+        20,
+        {{"All calls", -1}}};
+
     RSSI rssi_{
         {19 * 8 - 4, 3, UI_POS_WIDTH_REMAINING(26), 4}};
 
@@ -112,11 +250,55 @@ class MBELIBView : public View {
     std::filesystem::path selected_file_{};
     std::filesystem::path wav_file_{};
     File input_file_{};
+    AmbeReadAhead read_ahead_{};
+    // Selected file: v2 call list (the newest kMaxListedCalls calls, the
+    // first being call first_listed_call_) and frame count
+    std::vector<ambe_log::v2::CallEntry> calls_{};
+    uint32_t first_listed_call_{0};
+    uint32_t file_frames_{0};
+    int32_t selected_call_{-1};
+    // Decode thread: v2 block being read, and the call it is limited to
+    bool input_v2_{false};
+    int32_t decode_call_{-1};
+    uint32_t decode_first_block_{1};
+    ambe_log::v2::DataBlock block_{};
+    uint32_t block_sequence_{0};
+    size_t block_frame_{0};
+    bool block_last_{false};
+    uint32_t corrupt_run_{0};
+    uint32_t skip_block_frames_{0};  // Resume point inside the first block
+    // Checkpoints (Decode to PCM or uLaw WAV only)
+    bool checkpoints_enabled_{false};
+    bool resume_{false};
+    bool checkpoint_saved_{false};
+    DecodeCheckpoint checkpoint_{};
+    uint32_t frame_base_{0};      // Selection frame the session started reading at
+    uint32_t discard_frames_{0};  // Warm-up frames still to be thrown away
+    uint32_t last_checkpoint_frames_{0};
+    uint32_t frames_read_session_{0};
+    std::array<InputPosition, kInputPositions> input_positions_{};
+    File::Size input_size_{0};
+    File::Size input_consumed_{0};  // Input bytes the finished decode covered
+    bool wav_up_to_date_{false};    // Last Decode found nothing new to do
+    // Batch run: queue, position, and totals for the aggregate progress
+    std::vector<BatchEntry> batch_queue_{};
+    size_t batch_index_{0};
+    bool batch_active_{false};
+    bool batch_stop_{false};
+    bool baseband_kept_{false};  // PA2D still loaded from the previous file
+    uint64_t batch_bytes_total_{0};
+    uint64_t batch_bytes_done_{0};
+    uint32_t batch_frames_done_{0};
+    uint32_t batch_done_{0};
+    uint32_t batch_failed_{0};
+    systime_t batch_start_{0};
     File output_file_{};
     bool file_open_{false};
     bool output_ready_{false};
     bool wav_available_{false};
     bool decode_in_progress_{false};
+    bool stream_mode_{false};
+    bool play_wav_{false};
     std::atomic<bool> decode_abort_{false};
     Thread* decode_thread_{nullptr};
     DecodeResult decode_result_{};
@@ -127,33 +309,29 @@ class MBELIBView : public View {
     bool decode_thread_finished_{false};
     bool m4_completion_ack_received_{false};
     bool decode_finalized_{false};
+    bool wav_write_failed_{false};  // The decode was aborted on an SD write error
     uint32_t frames_processed_latest_{0};
     uint32_t total_frames_expected_{0};
     uint32_t frames_in_flight_{0};
     uint32_t max_frames_in_flight_{0};
     uint32_t frames_read_total_{0};
     uint32_t read_error_count_{0};
+    uint32_t corrupt_block_count_{0};  // v2 blocks skipped on a bad CRC or read
     uint32_t m4_pcm_dropped_{0};
-    bool is_playing_{false};
-    bool ready_signal_{false};
-    std::unique_ptr<ReplayThread> replay_thread_{};
+    uint32_t m4_frames_skipped_{0};  // Quiet frames that skipped the vocoder
+    uint32_t read_kib_per_second_{0};
+    uint32_t wav_sample_rate_{mbelib_audio::kPlaybackSampleRate};
+    uint32_t output_sample_rate_{mbelib_audio::kPlaybackSampleRate};
+    mbelib_audio::WavFormat wav_format_{mbelib_audio::WavFormat::Pcm16};
+    mbelib_audio::WavFormat output_format_{mbelib_audio::WavFormat::Pcm16};
+    uint32_t total_data_bytes_{0};
+    std::array<int16_t, kPlaybackBufferSamples> playback_buffer_{};
     Mutex file_io_mutex_{};
-    MessageHandlerRegistration replay_done_handler_{
-        Message::ID::ReplayThreadDone,
-        [this](const Message* const p) {
-            const auto message = *reinterpret_cast<const ReplayThreadDoneMessage*>(p);
-            on_replay_done(message.return_code);
-        }};
     MessageHandlerRegistration request_signal_handler_{
         Message::ID::RequestSignal,
         [this](const Message* const p) {
             const auto message = static_cast<const RequestSignalMessage*>(p);
             switch (message->signal) {
-                case RequestSignalMessage::Signal::FillRequest:
-                    if (replay_thread_) {
-                        ready_signal_ = true;
-                    }
-                    break;
                 case RequestSignalMessage::Signal::AmbeDecodeDone:
                     handle_decode_complete();
                     break;
@@ -174,6 +352,12 @@ class MBELIBView : public View {
             const auto& message = *reinterpret_cast<const AMBEPCMFrameMessage*>(p);
             on_pcm_frame(message);
         }};
+    MessageHandlerRegistration wav_data_handler_{
+        Message::ID::AMBEWavData,
+        [this](const Message* const p) {
+            const auto& message = *reinterpret_cast<const AMBEWavDataMessage*>(p);
+            on_wav_data(message);
+        }};
     MessageHandlerRegistration decode_stats_handler_{
         Message::ID::AMBE2DecodeStats,
         [this](const Message* const p) {
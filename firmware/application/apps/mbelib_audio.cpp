@@ -0,0 +1,497 @@
+/*
+ * Copyright (C) 2025 comparchitect (https://github.com/comparchitect)
+ */
+
+#include "mbelib_audio.hpp"
+
+#if defined(__ARM_FEATURE_DSP) || defined(MBELIB_AUDIO_DSP)
+#include "hal.h"
+#endif
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace mbelib_audio {
+
+namespace {
+
+/* 96-tap Kaiser (beta 5.65) low-pass at 48 kHz, cutoff 4 kHz, gain 6, in
+ * Q15: flat to 3 kHz, -3 dB at 3.8 kHz, images about -60 dB down from 5 kHz.
+ * Row p is output phase p with the taps reversed, so column j multiplies
+ * window[n + j] and the newest input sample meets column 15. Each row sums
+ * to exactly 32768 (unity DC gain). */
+alignas(4) constexpr int16_t kInterpolatorTaps[kUpsampleFactor][Upsampler::kTapsPerPhase] = {
+    {-26, 74, -164, 320, -586, 1083, -2376, 32390, 2846, -1210, 647, -354, 184, -85, 32, -7},
+    {-58, 173, -396, 786, -1449, 2656, -5535, 29438, 9613, -3715, 1952, -1073, 565, -268, 105, -26},
+    {-62, 202, -477, 964, -1792, 3268, -6550, 24020, 17038, -5740, 2950, -1621, 864, -419, 171, -48},
+    {-48, 171, -419, 864, -1621, 2950, -5740, 17038, 24020, -6550, 3268, -1792, 964, -477, 202, -62},
+    {-26, 105, -268, 565, -1073, 1952, -3715, 9613, 29438, -5535, 2656, -1449, 786, -396, 173, -58},
+    {-7, 32, -85, 184, -354, 647, -1210, 2846, 32390, -2376, 1083, -586, 320, -164, 74, -26},
+};
+
+// Q30 accumulator rounding before the shift back to Q15. Rows 2 and 3 have
+// an absolute tap sum of 66186, so full-scale input with matching signs
+// reaches about 2.17e9: both kernels accumulate in 64 bits.
+constexpr int64_t kRound = 1 << 14;
+
+inline int16_t saturate_q15(int64_t acc) {
+    acc >>= 15;
+    if (acc > 32767) acc = 32767;
+    if (acc < -32768) acc = -32768;
+    return static_cast<int16_t>(acc);
+}
+
+}  // namespace
+
+void AutoGain::reset() {
+    gain_ = 50.0f;
+    peak_head_ = 0;
+    peak_count_ = 0;
+    frame_ = 0;
+}
+
+namespace {
+
+float peak_abs(const float* samples, size_t count) {
+    float max_val = 0.0f;
+    for (size_t i = 0; i < count; ++i) {
+        const float abs_val = std::fabs(samples[i]);
+        if (abs_val > max_val) {
+            max_val = abs_val;
+        }
+    }
+    return max_val;
+}
+
+}  // namespace
+
+void AutoGain::apply(float* samples, size_t count) {
+    if (!samples || count == 0) {
+        return;
+    }
+
+    // Detect max level (dsd.test style)
+    const float gaindelta = track(peak_abs(samples, count), count);
+
+    // Apply gain with smooth transitions
+    for (size_t i = 0; i < count; ++i) {
+        const float current_gain = gain_ + static_cast<float>(i) * gaindelta;
+        samples[i] *= current_gain;
+    }
+
+    gain_ += static_cast<float>(count) * gaindelta;
+}
+
+void AutoGain::apply_to_int16(const float* samples, size_t count, int16_t* output) {
+    if (!samples || !output || count == 0) {
+        return;
+    }
+
+    const float gaindelta = track(peak_abs(samples, count), count);
+
+    // The ramp index counts in float (exact below 2^24), so each sample
+    // gets the same gain as in apply()
+    float index = 0.0f;
+    size_t i = 0;
+#if defined(__ARM_FEATURE_DSP) || defined(MBELIB_AUDIO_DSP)
+    // VCVT saturates to int32, so SSAT alone gives to_int16()'s clamp;
+    // samples go out in pairs, one 32-bit store each
+    for (; i + 1 < count; i += 2) {
+        const int32_t a = static_cast<int32_t>(samples[i] * (gain_ + index * gaindelta));
+        index += 1.0f;
+        const int32_t b = static_cast<int32_t>(samples[i + 1] * (gain_ + index * gaindelta));
+        index += 1.0f;
+        const uint32_t pair = __PKHBT(static_cast<uint32_t>(__SSAT(a, 16)), static_cast<uint32_t>(__SSAT(b, 16)), 16);
+        std::memcpy(output + i, &pair, sizeof(pair));
+    }
+#endif
+    for (; i < count; ++i) {
+        float sample = samples[i] * (gain_ + index * gaindelta);
+        index += 1.0f;
+        if (sample > 32767.0f) sample = 32767.0f;
+        if (sample < -32768.0f) sample = -32768.0f;
+        output[i] = static_cast<int16_t>(sample);
+    }
+
+    gain_ += static_cast<float>(count) * gaindelta;
+}
+
+void AutoGain::apply_silence(size_t count) {
+    if (count == 0) {
+        return;
+    }
+
+    const float gaindelta = track(0.0f, count);
+    gain_ += static_cast<float>(count) * gaindelta;
+}
+
+/* Pushes a frame peak and returns the maximum over the history window. */
+float AutoGain::history_max(float max_val) {
+    // Expire the peak that has left the window (at most one per frame)
+    if (peak_count_ > 0 && frame_ - peak_frames_[peak_head_] >= kHistoryFrames) {
+        peak_head_ = (peak_head_ + 1) % kHistoryFrames;
+        --peak_count_;
+    }
+
+    // Older peaks no larger than this one can never be the maximum again
+    while (peak_count_ > 0) {
+        const size_t back = (peak_head_ + peak_count_ - 1) % kHistoryFrames;
+        if (peak_values_[back] > max_val) {
+            break;
+        }
+        --peak_count_;
+    }
+
+    const size_t slot = (peak_head_ + peak_count_) % kHistoryFrames;
+    peak_values_[slot] = max_val;
+    peak_frames_[slot] = frame_;
+    ++peak_count_;
+    ++frame_;
+
+    return peak_values_[peak_head_];
+}
+
+/* Records a frame peak and returns the per-sample gain step. */
+float AutoGain::track(float max_val, size_t count) {
+    const float max_history = history_max(max_val);
+
+    // Determine optimal gain level (dsd.test algorithm)
+    float gainfactor = 50.0f;  // Default gain
+    if (max_history > 0.0f) {
+        gainfactor = 30000.0f / max_history;
+    }
+
+    float gaindelta = 0.0f;
+    if (gainfactor < gain_) {
+        // Immediate gain reduction
+        gain_ = gainfactor;
+    } else {
+        // Gradual gain increase
+        if (gainfactor > 50.0f) {
+            gainfactor = 50.0f;
+        }
+        gaindelta = gainfactor - gain_;
+        if (gaindelta > (0.05f * gain_)) {
+            gaindelta = 0.05f * gain_;
+        }
+    }
+
+    return gaindelta / static_cast<float>(count);
+}
+
+void to_int16(const float* input, int16_t* output, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        float sample = input[i];
+        if (sample > 32767.0f) sample = 32767.0f;
+        if (sample < -32768.0f) sample = -32768.0f;
+        output[i] = static_cast<int16_t>(sample);
+    }
+}
+
+void Upsampler::reset() {
+    window_.fill(0);
+}
+
+size_t Upsampler::process(const int16_t* input, size_t count, int16_t* output) {
+#if defined(__ARM_FEATURE_DSP) || defined(MBELIB_AUDIO_DSP)
+    return process_dsp(input, count, output);
+#else
+    return process_generic(input, count, output);
+#endif
+}
+
+size_t Upsampler::process_generic(const int16_t* input, size_t count, int16_t* output) {
+    if (!input || !output) {
+        return 0;
+    }
+
+    size_t out_idx = 0;
+    while (count > 0) {
+        const size_t block = std::min(count, kFrameSamples);
+        std::copy(input, input + block, window_.begin() + kHistory);
+
+        for (size_t n = 0; n < block; ++n) {
+            const int16_t* x = window_.data() + n;
+            for (size_t p = 0; p < kUpsampleFactor; ++p) {
+                const int16_t* h = kInterpolatorTaps[p];
+                int64_t acc = kRound;
+                for (size_t j = 0; j < kTapsPerPhase; ++j) {
+                    acc += static_cast<int32_t>(h[j]) * x[j];
+                }
+                output[out_idx++] = saturate_q15(acc);
+            }
+        }
+
+        std::copy(window_.begin() + block, window_.begin() + block + kHistory, window_.begin());
+        input += block;
+        count -= block;
+    }
+    return out_idx;
+}
+
+#if defined(__ARM_FEATURE_DSP) || defined(MBELIB_AUDIO_DSP)
+size_t Upsampler::process_dsp(const int16_t* input, size_t count, int16_t* output) {
+    if (!input || !output) {
+        return 0;
+    }
+
+    constexpr size_t kPairs = kTapsPerPhase / 2;
+
+    size_t out_idx = 0;
+    while (count > 0) {
+        const size_t block = std::min(count, kFrameSamples);
+        std::copy(input, input + block, window_.begin() + kHistory);
+
+        for (size_t n = 0; n < block; ++n) {
+            // The eight sample pairs are shared by all six phases. Every
+            // other n they sit at an odd halfword; the M4 handles unaligned
+            // LDR, and memcpy lets the compiler emit one.
+            uint32_t x[kPairs];
+            std::memcpy(x, window_.data() + n, sizeof(x));
+
+            for (size_t p = 0; p < kUpsampleFactor; ++p) {
+                uint32_t h[kPairs];
+                std::memcpy(h, kInterpolatorTaps[p], sizeof(h));
+                int64_t acc = kRound;
+                for (size_t k = 0; k < kPairs; ++k) {
+                    acc = static_cast<int64_t>(__SMLALD(h[k], x[k], static_cast<uint64_t>(acc)));
+                }
+                // |acc| < 2^32, so the Q15 result fits 32 bits for SSAT
+                output[out_idx++] = static_cast<int16_t>(__SSAT(static_cast<int32_t>(acc >> 15), 16));
+            }
+        }
+
+        std::copy(window_.begin() + block, window_.begin() + block + kHistory, window_.begin());
+        input += block;
+        count -= block;
+    }
+    return out_idx;
+}
+#endif
+
+namespace {
+
+constexpr int16_t kImaStepTable[89] = {
+    7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31,
+    34, 37, 41, 45, 50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130, 143,
+    157, 173, 190, 209, 230, 253, 279, 307, 337, 371, 408, 449, 494, 544, 598, 658,
+    724, 796, 876, 963, 1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066, 2272, 2499, 2749, 3024,
+    3327, 3660, 4026, 4428, 4871, 5358, 5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487, 12635, 13899,
+    15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767};
+
+constexpr int8_t kImaIndexTable[16] = {
+    -1, -1, -1, -1, 2, 4, 6, 8,
+    -1, -1, -1, -1, 2, 4, 6, 8};
+
+uint8_t* put_tag(uint8_t* p, const char* tag) {
+    for (size_t i = 0; i < 4; ++i) {
+        *p++ = static_cast<uint8_t>(tag[i]);
+    }
+    return p;
+}
+
+uint8_t* put16(uint8_t* p, uint32_t value) {
+    *p++ = static_cast<uint8_t>(value);
+    *p++ = static_cast<uint8_t>(value >> 8);
+    return p;
+}
+
+uint8_t* put32(uint8_t* p, uint32_t value) {
+    p = put16(p, value & 0xffff);
+    return put16(p, value >> 16);
+}
+
+}  // namespace
+
+size_t wav_header_size(WavFormat format) {
+    switch (format) {
+        case WavFormat::MuLaw:
+            return 58;  // fmt 18 (cbSize 0) + fact
+        case WavFormat::ImaAdpcm:
+            return 60;  // fmt 20 (cbSize 2, wSamplesPerBlock) + fact
+        default:
+            return 44;
+    }
+}
+
+size_t make_wav_header(WavFormat format,
+                       uint32_t sample_rate,
+                       uint32_t sample_count,
+                       uint32_t data_bytes,
+                       uint8_t* out) {
+    uint16_t format_tag = 1;
+    uint16_t bits_per_sample = 16;
+    uint16_t block_align = 2;
+    uint32_t byte_rate = sample_rate * 2;
+    uint32_t fmt_size = 16;
+
+    if (format == WavFormat::MuLaw) {
+        format_tag = 7;
+        bits_per_sample = 8;
+        block_align = 1;
+        byte_rate = sample_rate;
+        fmt_size = 18;
+    } else if (format == WavFormat::ImaAdpcm) {
+        format_tag = 0x11;
+        bits_per_sample = 4;
+        block_align = kImaBlockAlign;
+        byte_rate = static_cast<uint32_t>((static_cast<uint64_t>(sample_rate) * kImaBlockAlign) / kImaSamplesPerBlock);
+        fmt_size = 20;
+    }
+
+    const size_t header_size = wav_header_size(format);
+    uint8_t* p = out;
+    p = put_tag(p, "RIFF");
+    p = put32(p, static_cast<uint32_t>(header_size - 8 + data_bytes));
+    p = put_tag(p, "WAVE");
+    p = put_tag(p, "fmt ");
+    p = put32(p, fmt_size);
+    p = put16(p, format_tag);
+    p = put16(p, 1);  // Mono
+    p = put32(p, sample_rate);
+    p = put32(p, byte_rate);
+    p = put16(p, block_align);
+    p = put16(p, bits_per_sample);
+    if (format == WavFormat::MuLaw) {
+        p = put16(p, 0);  // cbSize
+    } else if (format == WavFormat::ImaAdpcm) {
+        p = put16(p, 2);  // cbSize
+        p = put16(p, kImaSamplesPerBlock);
+    }
+    if (format != WavFormat::Pcm16) {
+        p = put_tag(p, "fact");
+        p = put32(p, 4);
+        p = put32(p, sample_count);
+    }
+    p = put_tag(p, "data");
+    p = put32(p, data_bytes);
+    return static_cast<size_t>(p - out);
+}
+
+uint8_t linear_to_mulaw(int16_t sample) {
+    constexpr int32_t kBias = 0x84;
+    constexpr int32_t kClip = 32635;
+
+    int32_t value = sample;
+    const uint8_t sign = (value < 0) ? 0x80 : 0x00;
+    if (value < 0) {
+        value = -value;
+    }
+    if (value > kClip) {
+        value = kClip;
+    }
+    value += kBias;
+
+    uint8_t exponent = 7;
+    for (int32_t mask = 0x4000; ((value & mask) == 0) && (exponent > 0); mask >>= 1) {
+        --exponent;
+    }
+    const uint8_t mantissa = static_cast<uint8_t>((value >> (exponent + 3)) & 0x0f);
+    return static_cast<uint8_t>(~(sign | (exponent << 4) | mantissa));
+}
+
+void WavEncoder::reset(WavFormat format) {
+    format_ = format;
+    predictor_ = 0;
+    step_index_ = 0;
+    block_position_ = 0;
+    pending_nibble_ = 0;
+}
+
+size_t WavEncoder::encode(const int16_t* input, size_t count, uint8_t* out) {
+    size_t written = 0;
+    switch (format_) {
+        case WavFormat::Pcm16:
+            for (size_t i = 0; i < count; ++i) {
+                put16(out + written, static_cast<uint16_t>(input[i]));
+                written += 2;
+            }
+            break;
+
+        case WavFormat::MuLaw:
+            for (size_t i = 0; i < count; ++i) {
+                out[written++] = linear_to_mulaw(input[i]);
+            }
+            break;
+
+        case WavFormat::ImaAdpcm:
+            for (size_t i = 0; i < count; ++i) {
+                written += encode_ima(input[i], out + written);
+            }
+            break;
+    }
+    return written;
+}
+
+size_t WavEncoder::flush(uint8_t* out) {
+    size_t written = 0;
+    if (format_ == WavFormat::ImaAdpcm) {
+        while (block_position_ != 0) {
+            written += encode_ima(0, out + written);
+        }
+    }
+    return written;
+}
+
+size_t WavEncoder::encode_ima(int16_t sample, uint8_t* out) {
+    // Block header: the first sample verbatim plus the current step index
+    if (block_position_ == 0) {
+        predictor_ = sample;
+        put16(out, static_cast<uint16_t>(sample));
+        out[2] = static_cast<uint8_t>(step_index_);
+        out[3] = 0;
+        block_position_ = 1;
+        return 4;
+    }
+
+    int32_t diff = sample - predictor_;
+    uint8_t nibble = 0;
+    if (diff < 0) {
+        nibble = 8;
+        diff = -diff;
+    }
+
+    int32_t step = kImaStepTable[step_index_];
+    int32_t vpdiff = step >> 3;
+    if (diff >= step) {
+        nibble |= 4;
+        diff -= step;
+        vpdiff += step;
+    }
+    step >>= 1;
+    if (diff >= step) {
+        nibble |= 2;
+        diff -= step;
+        vpdiff += step;
+    }
+    step >>= 1;
+    if (diff >= step) {
+        nibble |= 1;
+        vpdiff += step;
+    }
+
+    predictor_ += (nibble & 8) ? -vpdiff : vpdiff;
+    if (predictor_ > 32767) predictor_ = 32767;
+    if (predictor_ < -32768) predictor_ = -32768;
+
+    step_index_ += kImaIndexTable[nibble];
+    if (step_index_ < 0) step_index_ = 0;
+    if (step_index_ > 88) step_index_ = 88;
+
+    // Two samples per byte, earlier sample in the low nibble
+    size_t written = 0;
+    if ((block_position_ & 1) != 0) {
+        pending_nibble_ = nibble;
+    } else {
+        out[0] = static_cast<uint8_t>(pending_nibble_ | (nibble << 4));
+        written = 1;
+    }
+
+    if (++block_position_ == kImaSamplesPerBlock) {
+        block_position_ = 0;
+    }
+    return written;
+}
+
+}  // namespace mbelib_audio
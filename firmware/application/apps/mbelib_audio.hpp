@@ -0,0 +1,268 @@
+/*
+ * Copyright (C) 2025 comparchitect (https://github.com/comparchitect)
+ */
+
+/*
+ * MBELIB audio post-processing shared by the PA2D baseband (AGC, int16
+ * conversion), the MBELIB view (6x upsampling, WAV header) and the host
+ * tools, so a WAV produced off-device matches the one written on the SD card.
+ *
+ * Floating point here must not be contracted into FMAs: both the baseband
+ * and the host build compile this with -ffp-contract=off.
+ */
+
+#ifndef __MBELIB_AUDIO_H__
+#define __MBELIB_AUDIO_H__
+
+#include "apps/mbe_vocoder.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace mbelib_audio {
+
+constexpr uint32_t kDecodeSampleRate = 8000;
+constexpr size_t kUpsampleFactor = 6;
+constexpr uint32_t kPlaybackSampleRate = kDecodeSampleRate * kUpsampleFactor;
+constexpr size_t kFrameSamples = 160;
+constexpr size_t kUpsampledFrameSamples = kFrameSamples * kUpsampleFactor;
+constexpr size_t kMaxWavHeaderSize = 60;
+
+// Frames the view keeps queued to the baseband; the baseband sizes its
+// output buffers from it
+constexpr size_t kMaxFramesInFlight = 4;
+
+// Recorded in the view's decode manifests: bump it whenever the same
+// input and settings would decode to different audio
+constexpr uint32_t kDecoderVersion = 2;
+
+static_assert(kFrameSamples == mbe_vocoder::kFrameSamples, "one vocoder frame per PCM frame");
+
+/* dsd.test style AGC: gain tracks the peak over the last 25 frames, drops
+ * immediately and rises by at most 5% per frame, capped at 50. */
+class AutoGain {
+   public:
+    static constexpr size_t kHistoryFrames = 25;
+
+    void reset();
+    void apply(float* samples, size_t count);
+
+    /* apply() and to_int16() fused into one pass over the frame; output is
+     * identical to running the two in turn. Uses SSAT where the DSP
+     * extension is available. */
+    void apply_to_int16(const float* samples, size_t count, int16_t* output);
+
+    /* Same gain tracking as apply() over count zero samples, without
+     * touching any samples. */
+    void apply_silence(size_t count);
+
+   private:
+    float track(float max_val, size_t count);
+    float history_max(float max_val);
+
+    float gain_{50.0f};
+
+    // Monotonic max-deque of frame peaks: values fall from the front,
+    // which is the maximum of the last kHistoryFrames peaks. Each frame
+    // pushes once and pops at most what it pushed, so tracking is O(1).
+    std::array<float, kHistoryFrames> peak_values_{};
+    std::array<uint32_t, kHistoryFrames> peak_frames_{};
+    size_t peak_head_{0};
+    size_t peak_count_{0};
+    uint32_t frame_{0};
+};
+
+/* Clamps and truncates decoder output to int16. */
+void to_int16(const float* input, int16_t* output, size_t count);
+
+/* 8 kHz to 48 kHz Q15 polyphase FIR interpolator: 96-tap Kaiser low-pass
+ * cut at 4 kHz, split into six 16-tap phases. The delay line carries across
+ * frames, so output is continuous however the input is chunked; feed one
+ * decode run through one instance in order.
+ *
+ * process() uses the SIMD kernel where the DSP extension is available (M4,
+ * or host builds defining MBELIB_AUDIO_DSP with the intrinsics stub) and the
+ * generic kernel otherwise. Both produce identical output. */
+class Upsampler {
+   public:
+    static constexpr size_t kTapsPerPhase = 16;
+
+    void reset();
+
+    /* Writes count * kUpsampleFactor samples to output; returns that count. */
+    size_t process(const int16_t* input, size_t count, int16_t* output);
+
+    size_t process_generic(const int16_t* input, size_t count, int16_t* output);
+#if defined(__ARM_FEATURE_DSP) || defined(MBELIB_AUDIO_DSP)
+    size_t process_dsp(const int16_t* input, size_t count, int16_t* output);
+#endif
+
+   private:
+    static constexpr size_t kHistory = kTapsPerPhase - 1;
+
+    // Last kHistory input samples, then the block being processed
+    std::array<int16_t, kHistory + kFrameSamples> window_{};
+};
+
+/* WAV data encodings the decoder can write. All are mono and open in
+ * standard players. */
+enum class WavFormat : uint8_t {
+    Pcm16 = 0,  // WAVE_FORMAT_PCM, 16 bit
+    MuLaw,      // WAVE_FORMAT_MULAW (7), G.711, 8 bit, 2:1
+    ImaAdpcm    // WAVE_FORMAT_IMA_ADPCM (0x11), 4 bit, 4:1
+};
+
+constexpr size_t kImaBlockAlign = 256;
+constexpr size_t kImaSamplesPerBlock = (kImaBlockAlign - 4) * 2 + 1;
+
+size_t wav_header_size(WavFormat format);
+
+/* Writes the header for sample_count samples held in data_bytes bytes of
+ * data to out (kMaxWavHeaderSize bytes) and returns its size. PCM keeps the
+ * canonical 44-byte layout; the compressed formats carry cbSize and the
+ * fact chunk the spec requires for them. */
+size_t make_wav_header(WavFormat format,
+                       uint32_t sample_rate,
+                       uint32_t sample_count,
+                       uint32_t data_bytes,
+                       uint8_t* out);
+
+uint8_t linear_to_mulaw(int16_t sample);
+
+/* Streaming WAV data encoder. Samples go in in any chunk size; encoded
+ * bytes come out as soon as they are complete, so nothing but the ADPCM
+ * predictor state is held between calls. */
+class WavEncoder {
+   public:
+    void reset(WavFormat format);
+    WavFormat format() const { return format_; }
+
+    /* Bytes encode() can produce for count samples. */
+    static constexpr size_t max_encoded_bytes(size_t count) {
+        return count * sizeof(int16_t) + 4;
+    }
+
+    /* Encodes count samples into out; returns the bytes written. */
+    size_t encode(const int16_t* input, size_t count, uint8_t* out);
+
+    /* Completes a partial ADPCM block with silence (the fact chunk keeps
+     * the real length). Writes at most kImaBlockAlign bytes. */
+    size_t flush(uint8_t* out);
+
+   private:
+    size_t encode_ima(int16_t sample, uint8_t* out);
+
+    WavFormat format_{WavFormat::Pcm16};
+
+    // IMA ADPCM state
+    int32_t predictor_{0};
+    int32_t step_index_{0};
+    size_t block_position_{0};
+    uint8_t pending_nibble_{0};
+};
+
+using mbe_vocoder::FrameKind;
+
+inline FrameKind classify_frame(const uint8_t* packed) {
+    return mbe_vocoder::classify(packed);
+}
+
+inline bool is_quiet(FrameKind kind) {
+    return (kind == FrameKind::Erasure) || (kind == FrameKind::Silence);
+}
+
+/* Erasure fast path. mbelib answers an erasure frame (b0 120..123) with
+ * zeros and reinitialises its parameters, whatever state it was in and
+ * without drawing random numbers. Once one erasure has gone through the
+ * vocoder, the rest of the run would leave it exactly where it is, so those
+ * frames skip it and output the zeros it would have produced.
+ *
+ * Silence frames (b0 124..125) always go through: mbelib synthesizes them
+ * as unvoiced comfort noise, carries their parameters into the next frame
+ * and draws random phases (the window-gated comfort noise from
+ * tools/get-mbelib.sh makes that cheaper). So do frames with more than
+ * three C0 errors, which repeat the previous parameters until mbelib's
+ * repeat budget runs out.
+ *
+ * MBELIB_REFERENCE_DECODE (host ambe2wav_ref only) sends every frame to
+ * the vocoder, for A/B timing against the fast paths. */
+class QuietSkip {
+   public:
+    void reset() {
+        after_erasure_ = false;
+        skipped_ = 0;
+    }
+
+    /* Classifies one packed frame; true when it can skip the vocoder. */
+    bool skip(const uint8_t* packed) {
+#if defined(MBELIB_REFERENCE_DECODE)
+        (void)packed;
+        return false;
+#else
+        if (!mbe_vocoder::resets_decoder(packed)) {
+            after_erasure_ = false;
+            return false;
+        }
+        if (!after_erasure_) {
+            after_erasure_ = true;
+            return false;
+        }
+        ++skipped_;
+        return true;
+#endif
+    }
+
+    uint32_t skipped() const { return skipped_; }
+
+   private:
+    bool after_erasure_{false};
+    uint32_t skipped_{0};
+};
+
+/* Decodes one packed .ambe frame to 8 kHz float PCM, before AGC. Returns
+ * the number of samples written to pcm (at most kFrameSamples), 0 when the
+ * decoder produced nothing. */
+template <typename Decoder>
+size_t decode_frame_float(Decoder& decoder, const uint8_t* packed, float* pcm) {
+    // ECC was already applied at capture time; use the stored errs2
+    char params[mbe_vocoder::kParamBits] = {0};
+    const uint8_t errs2 = mbe_vocoder::unpack(packed, params);
+    const int produced = decoder.processDataFloat(params, 0, errs2, pcm, kFrameSamples);
+    return (produced > 0) ? static_cast<size_t>(produced) : 0;
+}
+
+/* decode_frame_float() behind the quiet fast path. */
+template <typename Decoder>
+size_t decode_frame_float(Decoder& decoder, QuietSkip& quiet, const uint8_t* packed, float* pcm) {
+    if (quiet.skip(packed)) {
+        std::fill(pcm, pcm + kFrameSamples, 0.0f);
+        return kFrameSamples;
+    }
+    return decode_frame_float(decoder, packed, pcm);
+}
+
+/* Decodes one packed .ambe frame to 8 kHz int16 PCM the way the PA2D
+ * baseband does. Returns the number of samples written to pcm. */
+template <typename Decoder>
+size_t decode_frame(Decoder& decoder, AutoGain& agc, QuietSkip& quiet, const uint8_t* packed, int16_t* pcm) {
+    if (quiet.skip(packed)) {
+        agc.apply_silence(kFrameSamples);
+        std::fill(pcm, pcm + kFrameSamples, 0);
+        return kFrameSamples;
+    }
+
+    std::array<float, kFrameSamples> float_pcm{};
+    const size_t produced = decode_frame_float(decoder, packed, float_pcm.data());
+    if (produced == 0) {
+        return 0;
+    }
+
+    agc.apply_to_int16(float_pcm.data(), produced, pcm);
+    return produced;
+}
+
+}  // namespace mbelib_audio
+
+#endif /*__MBELIB_AUDIO_H__*/
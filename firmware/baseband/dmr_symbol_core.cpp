@@ -0,0 +1,634 @@
+/*
+ * Copyright (C) 2025 comparchitect (https://github.com/comparchitect)
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "dmr_symbol_core.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <cstdlib>
+
+namespace {
+
+using SyncPatternId = DMRSymbolCore::SyncPatternId;
+
+struct SyncPatternDescriptor {
+    SyncPatternId id;
+    const char* pattern;
+};
+
+constexpr std::array<SyncPatternDescriptor, 8> kSyncPatterns{{
+    {SyncPatternId::DirectTs1Voice, "113111131333131311133333"},
+    {SyncPatternId::DirectTs1Data, "331333313111313133311111"},
+    {SyncPatternId::DirectTs2Voice, "133133333111331111311133"},
+    {SyncPatternId::DirectTs2Data, "311311111333113333133311"},
+    {SyncPatternId::BsVoice, "131111333113313313113313"},
+    {SyncPatternId::BsData, "313131111133331113111133"},
+    {SyncPatternId::MsVoice, "133313311131311113313331"},
+    {SyncPatternId::MsData, "331333113133111133331111"}
+}};
+
+int compare_int32(const void* a, const void* b) {
+    const auto av = *static_cast<const int32_t*>(a);
+    const auto bv = *static_cast<const int32_t*>(b);
+    if (av < bv) return -1;
+    if (av > bv) return 1;
+    return 0;
+}
+
+static constexpr int32_t dmr_coeffs_q23[61] = {
+    37032,
+    33065,
+    19611,
+    -1611,
+    -26605,
+    -49737,
+    -64869,
+    -66786,
+    -52609,
+    -22867,
+    18080,
+    62446,
+    100273,
+    121365,
+    117566,
+    84935,
+    25326,
+    -53007,
+    -136037,
+    -205827,
+    -243380,
+    -232032,
+    -160770,
+    -26851,
+    162827,
+    391930,
+    636544,
+    868433,
+    1059184,
+    1184549,
+    1228249,
+    1184549,
+    1059184,
+    868433,
+    636544,
+    391930,
+    162827,
+    -26851,
+    -160770,
+    -232032,
+    -243380,
+    -205827,
+    -136037,
+    -53007,
+    25326,
+    84935,
+    117566,
+    121365,
+    100273,
+    62446,
+    18080,
+    -22867,
+    -52609,
+    -66786,
+    -64869,
+    -49737,
+    -26605,
+    -1611,
+    19611,
+    33065,
+    37032
+};
+
+inline int16_t saturate_to_i16(int32_t x)
+{
+    if (x > INT16_MAX) return INT16_MAX;
+    if (x < INT16_MIN) return INT16_MIN;
+    return static_cast<int16_t>(x);
+}
+
+}  // namespace
+
+// ------------------------------------------------------------------
+// Higher-precision fixed-point RRC filter, delay line is per instance
+// ------------------------------------------------------------------
+int16_t DMRSymbolCore::dmr_filter(int16_t sample)
+{
+    // Shift delay line
+    for (int i = 0; i < kDmrNZeros; ++i) {
+        dmr_v_[i] = dmr_v_[i + 1];
+    }
+    dmr_v_[kDmrNZeros] = sample;
+
+    // 64-bit accumulator, value in Q23
+    int64_t acc = 0;
+
+    for (int i = 0; i <= kDmrNZeros; ++i) {
+        acc += static_cast<int64_t>(dmr_coeffs_q23[i]) *
+               static_cast<int64_t>(dmr_v_[i]);
+    }
+
+    // acc is Q23 (coeff Q23 * sample Q0), shift down to Q0
+    int32_t y = static_cast<int32_t>(acc >> 23);
+
+    return saturate_to_i16(y);
+}
+
+void DMRSymbolCore::reset() {
+    dibit_buf_.fill(0);
+    dibit_buf_index_ = 0;
+    parseState_ = Parse_State_Search_Sync;
+    active_burst_index_ = 0;
+    current_burst_start_absolute_ = 0;
+    current_burst_start_sample_ = 0;
+    current_burst_sync_ = SyncPatternId::Unknown;
+    current_burst_slot_ = 0;
+    last_voice_sync_ = SyncPatternId::Unknown;
+    live_total_bursts_ = 0;
+    sync_search_symbol_count_ = 0;
+    carrier_present_ = true;
+    symbol_counter_ = 0;
+    absolute_sample_index_ = 0;
+
+    stats_drop_filtered_ = 0;
+    stats_drop_slot_color_ = 0;
+    stats_sync_hits_ts1_ = 0;
+
+    symbol_samples_.fill(0);
+    current_symbol_sum_ = 0;
+    current_symbol_count_ = 0;
+    center_ = 0;
+    umid_ = 0;
+    lmid_ = 0;
+    max_sample_ = 15000;
+    min_sample_ = -15000;
+    max_ref_ = 12000;
+    min_ref_ = -12000;
+    last_filtered_sample_ = 0;
+    symbol_center_ = 4;
+    jitter_ = -1;
+    jitter_enabled_ = false;
+    dmr_filter_enabled_ = false;
+    std::fill(std::begin(dmr_v_), std::end(dmr_v_), 0);
+
+    lbuf1_pos_ = 0;
+    lmin_ = 0;
+    lmax_ = 0;
+
+    sync_history_.fill('0');
+    sync_history_pos_ = 0;
+    sync_history_count_ = 0;
+
+    work_count_ = 0;
+}
+
+void DMRSymbolCore::process_decided_symbol(uint8_t dibit) {
+    dibit_buf_[dibit_buf_index_] = dibit;
+    dibit_buf_index_ = (dibit_buf_index_ + 1) % DIBIT_BUF_SIZE;
+
+    if (parseState_ == Parse_State_Search_Sync) {
+        ++sync_search_symbol_count_;
+        SyncPatternId match_id = SyncPatternId::Unknown;
+
+        if (sync_history_count_ >= DMR_SYNC_SYMBOLS &&
+            (max_ref_ != max_sample_ || min_ref_ != min_sample_)) {
+            max_ref_ = max_sample_;
+            min_ref_ = min_sample_;
+        }
+
+        char sync_window[DMR_SYNC_SYMBOLS + 1]{};
+        std::fill_n(sync_window, DMR_SYNC_SYMBOLS + 1, '\0');
+        if (sync_history_count_ >= DMR_SYNC_SYMBOLS) {
+            build_sync_window(sync_window);
+            match_id = decode_sync_string(sync_window);
+        }
+
+        if (match_id == SyncPatternId::DirectTs1Voice || match_id == SyncPatternId::DirectTs1Data || match_id == SyncPatternId::DirectTs2Voice || match_id == SyncPatternId::DirectTs2Data  || match_id == SyncPatternId::MsVoice || match_id == SyncPatternId::BsVoice || match_id == SyncPatternId::MsData || match_id == SyncPatternId::BsData) {
+            carrier_present_ = true;
+            sync_search_symbol_count_ = 0;
+
+            std::memcpy(lbuf2_, lbuf1_, sizeof(lbuf1_));
+            ::qsort(lbuf2_, 24, sizeof(int32_t), compare_int32);
+            lmin_ = (lbuf2_[1] + lbuf2_[2] + lbuf2_[3]) / 3;
+            const int t_max = 24;
+            lmax_ = (lbuf2_[t_max - 3] + lbuf2_[t_max - 2] + lbuf2_[t_max - 1]) / 3;
+
+            max_sample_ = (max_sample_ + lmax_) / 2;
+            min_sample_ = (min_sample_ + lmin_) / 2;
+            center_ = (max_sample_ + min_sample_) / 2;
+            umid_ = (((max_sample_ - center_) * 5) / 8) + center_;
+            lmid_ = (((min_sample_ - center_) * 5) / 8) + center_;
+            max_ref_ = max_sample_;
+            min_ref_ = min_sample_;
+
+            jitter_enabled_ = true;
+            dmr_filter_enabled_ = true;
+
+            if (match_id == SyncPatternId::DirectTs1Voice || match_id == SyncPatternId::DirectTs2Voice || match_id == SyncPatternId::MsVoice || match_id == SyncPatternId::BsVoice) {
+                current_burst_start_absolute_ =
+                    (symbol_counter_ >= 90) ? symbol_counter_ - 90 : 0;
+                current_burst_start_sample_ = absolute_sample_index_;
+                current_burst_sync_ = match_id;
+                current_burst_slot_ = voice_slot(match_id);
+                last_voice_sync_ = match_id;
+                active_burst_index_ = 0;
+                dibit_index_ = 0;
+                parseState_ = Parse_State_Process_Voice;
+                sync_search_symbol_count_ = 0;
+            } else {
+                if (ends_voice(last_voice_sync_, match_id)) {
+                    emit_call_event(CallEvent::Terminator);
+                }
+                parseState_ = Parse_State_Process_Data;
+                data_sync_hold_symbols_ = 263;
+            }
+
+            stats_sync_hits_ts1_++;
+        }
+
+        if (sync_search_symbol_count_ >= static_cast<uint32_t>(kCarrierLossSymbolLimit)) {
+            handle_carrier_loss();
+            return;
+        }
+    } else if (parseState_ == Parse_State_Process_Voice) {
+        const uint16_t offset = static_cast<uint16_t>(symbol_counter_ - current_burst_start_absolute_);
+
+        auto wrap_index = [&](int idx) -> std::size_t {
+            const int mod = idx % static_cast<int>(DIBIT_BUF_SIZE);
+            return static_cast<std::size_t>((mod < 0) ? mod + static_cast<int>(DIBIT_BUF_SIZE) : mod);
+        };
+
+        auto append_dibits = [&](int start, std::size_t count) {
+            for (std::size_t i = 0; i < count && dibit_index_ < 108; ++i) {
+                const auto buf_index = wrap_index(start + static_cast<int>(i));
+                voice_dibits_[dibit_index_++] = dibit_buf_[buf_index];
+            }
+        };
+
+        const int burst_offset = static_cast<int>(active_burst_index_) * 288;
+        if (offset == static_cast<uint16_t>(91 + burst_offset)) {
+            append_dibits(static_cast<int>(dibit_buf_index_) -
+                              static_cast<int>(DMR_FRAME_SYMBOLS + DMR_FRAME2_HALF_SYMBOLS + DMR_SYNC_SYMBOLS + 1),
+                          DMR_FRAME_SYMBOLS);
+            append_dibits(static_cast<int>(dibit_buf_index_) -
+                              static_cast<int>(DMR_FRAME2_HALF_SYMBOLS + DMR_SYNC_SYMBOLS + 1),
+                          DMR_FRAME2_HALF_SYMBOLS);
+        } else if (offset == static_cast<uint16_t>(108 + burst_offset)) {
+            append_dibits(static_cast<int>(dibit_buf_index_) -
+                              static_cast<int>(DMR_FRAME2_HALF_SYMBOLS),
+                          DMR_FRAME2_HALF_SYMBOLS);
+        } else if (offset == static_cast<uint16_t>(144 + burst_offset)) {
+            append_dibits(static_cast<int>(dibit_buf_index_) -
+                              static_cast<int>(DMR_FRAME_SYMBOLS),
+                          DMR_FRAME_SYMBOLS);
+
+            uint8_t burst_bytes[kBurstBytes]{};
+            for (int i = 0; i < 108; ++i) {
+                const uint8_t temp = voice_dibits_[i] & 0x03u;
+                const int byte_index = i / 4;
+                const int slot = i % 4;
+                const int shift = 6 - (slot * 2);
+                if (!slot) {
+                    burst_bytes[byte_index] = 0;
+                }
+                burst_bytes[byte_index] |= static_cast<uint8_t>(temp << shift);
+            }
+            emit_burst(burst_bytes);
+
+            if (active_burst_index_ == 5) {
+                parseState_ = Parse_State_Process_Data;
+                data_sync_hold_symbols_ = 209;
+                sync_search_symbol_count_ = 0;
+            } else {
+                active_burst_index_++;
+                dibit_index_ = 0;
+            }
+        }
+    } else if (parseState_ == Parse_State_Process_Data) {
+        --data_sync_hold_symbols_;
+        if (data_sync_hold_symbols_ <= 0) {
+            parseState_ = Parse_State_Search_Sync;
+            sync_search_symbol_count_ = 0;
+        }
+    }
+}
+
+DMRSymbolCore::SyncPatternId DMRSymbolCore::decode_sync_string(const char* sync_chars) const {
+    if (!sync_chars) {
+        return SyncPatternId::Unknown;
+    }
+
+    auto matches = [&](const char* pattern) {
+        if (!pattern) {
+            return false;
+        }
+        for (size_t i = 0; i < DMR_SYNC_SYMBOLS; ++i) {
+            if (sync_chars[i] != pattern[i]) {
+                return false;
+            }
+        }
+        return true;
+    };
+
+    auto get_pattern = [&](SyncPatternId id) -> const char* {
+        for (const auto& desc : kSyncPatterns) {
+            if (desc.id == id) {
+                return desc.pattern;
+            }
+        }
+        return nullptr;
+    };
+
+    const char* pat_ts1_voice = get_pattern(SyncPatternId::DirectTs1Voice);
+    if (matches(pat_ts1_voice)) {
+        return SyncPatternId::DirectTs1Voice;
+    }
+
+    const char* pat_ts1_data = get_pattern(SyncPatternId::DirectTs1Data);
+    if (matches(pat_ts1_data)) {
+        return SyncPatternId::DirectTs1Data;
+    }
+
+    const char* pat_ts2_voice = get_pattern(SyncPatternId::DirectTs2Voice);
+    if (matches(pat_ts2_voice)) {
+        return SyncPatternId::DirectTs2Voice;
+    }
+
+    const char* pat_ts2_data = get_pattern(SyncPatternId::DirectTs2Data);
+    if (matches(pat_ts2_data)) {
+        return SyncPatternId::DirectTs2Data;
+    }
+
+    const char* pat_bs_voice = get_pattern(SyncPatternId::BsVoice);
+    if (matches(pat_bs_voice)) {
+        return SyncPatternId::BsVoice;
+    }
+
+    const char* pat_bs_data = get_pattern(SyncPatternId::BsData);
+    if (matches(pat_bs_data)) {
+        return SyncPatternId::BsData;
+    }
+
+    const char* pat_ms_voice = get_pattern(SyncPatternId::MsVoice);
+    if (matches(pat_ms_voice)) {
+        return SyncPatternId::MsVoice;
+    }
+
+    const char* pat_ms_data = get_pattern(SyncPatternId::MsData);
+    if (matches(pat_ms_data)) {
+        return SyncPatternId::MsData;
+    }
+
+    return SyncPatternId::Unknown;
+}
+
+void DMRSymbolCore::emit_burst(const uint8_t* burst_bytes) {
+    if (!burst_bytes) {
+        return;
+    }
+
+    live_total_bursts_++;
+
+    if (!burst_handler_) {
+        return;
+    }
+
+    Burst burst{};
+    burst.channel = channel_;
+    burst.sync = current_burst_sync_;
+    burst.slot = current_burst_slot_;
+    burst.start_sample = current_burst_start_sample_;
+    std::memcpy(burst.bytes, burst_bytes, kBurstBytes);
+    burst_handler_(burst_context_, burst);
+}
+
+void DMRSymbolCore::emit_call_event(CallEvent event) {
+    last_voice_sync_ = SyncPatternId::Unknown;
+    if (call_event_handler_) {
+        call_event_handler_(call_event_context_, channel_, event, absolute_sample_index_);
+    }
+}
+
+/* Timeslot of a voice superframe, called when its sync has just been
+ * read. Direct mode has one sync pattern per slot. A base station says it
+ * in the TC bit of the CACH that opens the burst: the high bit of its
+ * third dibit, 88 dibits before the end of the sync. The following
+ * bursts of the superframe are 288 symbols apart, so they are on the same
+ * slot. A mobile's sync does not carry its slot. */
+uint8_t DMRSymbolCore::voice_slot(SyncPatternId voice) const {
+    switch (voice) {
+        case SyncPatternId::DirectTs1Voice:
+            return 1;
+        case SyncPatternId::DirectTs2Voice:
+            return 2;
+        case SyncPatternId::BsVoice: {
+            constexpr size_t kTcDibit = DMR_SYNC_OFFSET_FROM_BURST_START + DMR_SYNC_SYMBOLS - (DMR_CACH_START + 2);
+            const size_t index = (dibit_buf_index_ + DIBIT_BUF_SIZE - kTcDibit) % DIBIT_BUF_SIZE;
+            return static_cast<uint8_t>(((dibit_buf_[index] >> 1) & 0x01u) + 1);
+        }
+        default:
+            return 0;
+    }
+}
+
+/* A mobile or direct-mode transmitter sends one slot, so a data burst with
+ * the same source's sync after its voice is the terminator with LC. A base
+ * station interleaves the other slot's idle and data bursts with voice, so
+ * BS calls end on carrier loss or the writer's gap instead. */
+bool DMRSymbolCore::ends_voice(SyncPatternId voice, SyncPatternId data) {
+    switch (voice) {
+        case SyncPatternId::MsVoice:
+            return data == SyncPatternId::MsData;
+        case SyncPatternId::DirectTs1Voice:
+            return data == SyncPatternId::DirectTs1Data;
+        case SyncPatternId::DirectTs2Voice:
+            return data == SyncPatternId::DirectTs2Data;
+        default:
+            return false;
+    }
+}
+
+void DMRSymbolCore::process(const int16_t* audio, size_t sample_count) {
+    // Instrument input block size for debugging.
+    stats_drop_filtered_ = sample_count;
+
+    uint32_t symbols_this_block = 0;
+    while (sample_count > 0) {
+        // Top up the work buffer behind the samples carried from last time.
+        const std::size_t take = std::min(sample_count, work_.size() - work_count_);
+        std::copy_n(audio, take, work_.data() + work_count_);
+        work_count_ += take;
+        audio += take;
+        sample_count -= take;
+
+        std::size_t offset = 0;
+        while (work_count_ - offset >= kMinSymbolSamples) {
+            int sum = 0;
+            int count = 0;
+            int32_t symbol = 0;
+            if (!getSymbolFromBuffer(work_.data(), work_count_, offset, sum, count, symbol)) {
+                break;
+            }
+
+            update_symbol_statistics(symbol);
+            const char sign_char = (symbol > center_) ? '1' : '3';
+            push_sync_char(sign_char);
+
+            uint8_t dibit;
+            if (symbol > center_) {
+                dibit = (symbol > umid_) ? 0b01u : 0b00u;
+            } else {
+                dibit = (symbol < lmid_) ? 0b11u : 0b10u;
+            }
+            process_decided_symbol(dibit & 0x03u);
+            ++symbols_this_block;
+        }
+
+        // Fewer than kMinSymbolSamples remain; keep them for the next pass.
+        std::copy(work_.begin() + offset, work_.begin() + work_count_, work_.begin());
+        work_count_ -= offset;
+    }
+
+    // Expose how many symbols were processed in this block.
+    stats_drop_slot_color_ = symbols_this_block;
+}
+
+bool DMRSymbolCore::getSymbolFromBuffer(const int16_t* samples,
+                                         std::size_t size,
+                                         std::size_t& offset,
+                                         int& sum_out,
+                                         int& count_out,
+                                         int32_t& symbol_out) {
+    const int samples_per_symbol = static_cast<int>(symbol_samples_.size());
+    if (size - offset < static_cast<std::size_t>(samples_per_symbol)) {
+        return false;
+    }
+
+    sum_out = 0;
+    count_out = 0;
+
+    for (int loop_i = 0; loop_i < samples_per_symbol; loop_i++) {
+        if (loop_i == 0 && parseState_ == Parse_State_Search_Sync) {
+            if (jitter_ >= symbol_center_ - 1 && jitter_ <= symbol_center_) {
+                loop_i--;
+            } else if (jitter_ >= symbol_center_ + 1 && jitter_ <= symbol_center_ + 2) {
+                loop_i++;
+            }
+            jitter_ = -1;
+        }
+
+        if (offset >= size) {
+            return false;
+        }
+
+        int16_t pre_filter_sample = samples[offset++];
+        absolute_sample_index_++;
+
+        int16_t filtered_sample = pre_filter_sample;
+        if (dmr_filter_enabled_) {
+            filtered_sample = dmr_filter(filtered_sample);
+        }
+        const int32_t filtered_int = static_cast<int32_t>(filtered_sample);
+
+        if (jitter_ < 0) {
+            const int32_t maxref_scaled = (max_ref_ * 5) / 4;
+            const int32_t minref_scaled = (min_ref_ * 5) / 4;
+
+            bool should_set = false;
+            if (filtered_int > center_) {
+                if (filtered_int <= maxref_scaled && last_filtered_sample_ < center_) {
+                    should_set = true;
+                }
+            } else {
+                if (filtered_int >= minref_scaled && last_filtered_sample_ > center_) {
+                    should_set = true;
+                }
+            }
+
+            if (should_set) {
+                jitter_ = loop_i;
+            }
+        }
+
+        if ((loop_i == symbol_center_ - 1 ||
+             loop_i == symbol_center_ + 1)) {
+            sum_out += filtered_int;
+            ++count_out;
+        }
+
+        last_filtered_sample_ = filtered_int;
+    }
+
+    const int divisor = (count_out > 0) ? count_out : 1;
+    symbol_out = sum_out / divisor;
+    ++symbol_counter_;
+    return true;
+}
+
+void DMRSymbolCore::build_sync_window(char* dest) const {
+    if (!dest) {
+        return;
+    }
+    if (sync_history_count_ < DMR_SYNC_SYMBOLS) {
+        std::fill(dest, dest + DMR_SYNC_SYMBOLS, '0');
+        return;
+    }
+    const std::size_t start =
+        (sync_history_pos_ + kSyncHistorySize - DMR_SYNC_SYMBOLS) % kSyncHistorySize;
+    for (std::size_t i = 0; i < DMR_SYNC_SYMBOLS; ++i) {
+        const std::size_t idx = (start + i) % kSyncHistorySize;
+        dest[i] = sync_history_[idx];
+    }
+}
+
+void DMRSymbolCore::push_sync_char(char c) {
+    sync_history_[sync_history_pos_] = c;
+    sync_history_pos_ = (sync_history_pos_ + 1) % kSyncHistorySize;
+    if (sync_history_count_ < kSyncHistorySize) {
+        ++sync_history_count_;
+    }
+}
+
+void DMRSymbolCore::handle_carrier_loss() {
+    // Fires every kCarrierLossSymbolLimit symbols while idle; report the first
+    if (carrier_present_) {
+        emit_call_event(CallEvent::CarrierLoss);
+    }
+    carrier_present_ = false;
+    jitter_ = -1;
+    center_ = 0;
+    sync_search_symbol_count_ = 0;
+    symbol_counter_ = 0;
+    parseState_ = Parse_State_Search_Sync;
+    active_burst_index_ = 0;
+    dibit_index_ = 0;
+    current_burst_start_absolute_ = 0;
+    umid_ = (((max_sample_ - center_) * 5) / 8) + center_;
+    lmid_ = (((min_sample_ - center_) * 5) / 8) + center_;
+    max_ref_ = max_sample_;
+    min_ref_ = min_sample_;
+}
+
+void DMRSymbolCore::update_symbol_statistics(int32_t symbol_value) {
+    lbuf1_[lbuf1_pos_] = symbol_value;
+    lbuf1_pos_ = (lbuf1_pos_ + 1) % 24;
+}
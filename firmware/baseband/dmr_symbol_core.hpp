@@ -0,0 +1,219 @@
+/*
+ * Copyright (C) 2025 comparchitect (https://github.com/comparchitect)
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __DMR_SYMBOL_CORE_H__
+#define __DMR_SYMBOL_CORE_H__
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+/* DMR symbol recovery: RRC filter, level tracking, slicer, sync search and
+ * voice burst assembly. Takes 48 kHz FM-demodulated samples (10 samples per
+ * symbol) and reports each assembled 27-byte voice burst through a callback.
+ * Holds no global state and never allocates, so any number of instances can
+ * run side by side (one per channel in a channelizer, one per file in a host
+ * tool); each instance is about 2.5 KB. */
+class DMRSymbolCore {
+   public:
+    enum class SyncPatternId : uint8_t {
+        Unknown = 0,
+        BsVoice,
+        BsData,
+        MsVoice,
+        MsData,
+        DirectTs1Voice,
+        DirectTs1Data,
+        DirectTs2Voice,
+        DirectTs2Data,
+        BsVoiceInverted,
+        BsDataInverted,
+        MsVoiceInverted,
+        MsDataInverted,
+        DirectTs1VoiceInverted,
+        DirectTs1DataInverted,
+        DirectTs2VoiceInverted,
+        DirectTs2DataInverted
+    };
+
+    enum Parse_State {
+        Parse_State_Search_Sync = 0,
+        Parse_State_Process_Voice,
+        Parse_State_Process_Data
+    };
+
+    static constexpr size_t kBurstBytes{27};
+
+    struct Burst {
+        uint8_t channel;
+        SyncPatternId sync;
+        uint8_t slot;           // 1 or 2, 0 when the burst does not say (MS)
+        uint64_t start_sample;  // Sample index (48 kHz) where the burst's sync was found
+        uint8_t bytes[kBurstBytes];
+    };
+
+    using BurstHandler = void (*)(void* context, const Burst& burst);
+
+    // Why a call on this channel ended, as seen from the air interface
+    enum class CallEvent : uint8_t {
+        CarrierLoss = 1,  // No sync for kCarrierLossSymbolLimit symbols
+        Terminator        // MS or direct-mode data sync right after voice
+    };
+
+    // sample is the 48 kHz sample index the event was detected at
+    using CallEventHandler = void (*)(void* context, uint8_t channel, CallEvent event, uint64_t sample);
+
+    explicit DMRSymbolCore(uint8_t channel = 0)
+        : channel_{channel} { reset(); }
+
+    void set_burst_handler(BurstHandler handler, void* context) {
+        burst_handler_ = handler;
+        burst_context_ = context;
+    }
+
+    void set_call_event_handler(CallEventHandler handler, void* context) {
+        call_event_handler_ = handler;
+        call_event_context_ = context;
+    }
+
+    void set_channel(uint8_t channel) { channel_ = channel; }
+    uint8_t channel() const { return channel_; }
+
+    void reset();
+    void process(const int16_t* samples, size_t sample_count);
+
+    uint32_t bursts() const { return live_total_bursts_; }
+    uint32_t sync_hits() const { return stats_sync_hits_ts1_; }
+    uint64_t symbol_count() const { return symbol_counter_; }
+    uint64_t sample_count() const { return absolute_sample_index_; }
+    Parse_State parse_state() const { return parseState_; }
+    int32_t min_ref() const { return min_ref_; }
+    int32_t max_ref() const { return max_ref_; }
+    int center() const { return center_; }
+
+   private:
+    // Burst processing
+    static constexpr size_t DMR_CACH_SYMBOLS{12};
+    static constexpr size_t DMR_FRAME_SYMBOLS{36};
+    static constexpr size_t DMR_FRAME2_HALF_SYMBOLS{18};
+    static constexpr size_t DMR_SYNC_SYMBOLS{24};
+    static constexpr size_t DMR_CACH_START{0};
+    static constexpr size_t DMR_SLOT_TYPE_OFFSET_FROM_CACH{49};
+    static constexpr size_t DMR_FRAME1_START{DMR_CACH_START + DMR_CACH_SYMBOLS};
+    static constexpr size_t DMR_FRAME2A_START{DMR_FRAME1_START + DMR_FRAME_SYMBOLS};
+    static constexpr size_t DMR_SYNC_OFFSET_FROM_BURST_START{DMR_FRAME2A_START + DMR_FRAME2_HALF_SYMBOLS};
+    static constexpr size_t DMR_FRAME2B_START{DMR_SYNC_OFFSET_FROM_BURST_START + DMR_SYNC_SYMBOLS};
+    static constexpr size_t DMR_FRAME3_START{DMR_FRAME2B_START + DMR_FRAME2_HALF_SYMBOLS};
+    static constexpr size_t DMR_BURST_SYMBOLS{DMR_FRAME3_START + DMR_FRAME_SYMBOLS};
+
+    static constexpr size_t DIBIT_BUF_SIZE{288 * 6};
+    static constexpr size_t kSyncHistorySize{32};  // Only the last DMR_SYNC_SYMBOLS are ever read
+    static constexpr size_t kSymbolSamples{10};
+    static constexpr size_t kMinSymbolSamples{kSymbolSamples + 10};  // One symbol plus jitter margin
+    static constexpr size_t kWorkChunk{128};
+    static constexpr int kCarrierLossSymbolLimit{1800};
+    static constexpr int kDmrNZeros{60};
+
+    void process_decided_symbol(uint8_t symbol);
+    void update_symbol_statistics(int32_t symbol_value);
+    bool getSymbolFromBuffer(const int16_t* samples,
+                             std::size_t size,
+                             std::size_t& offset,
+                             int& sum_out,
+                             int& count_out,
+                             int32_t& symbol_out);
+    void build_sync_window(char* dest) const;
+    void push_sync_char(char c);
+    void handle_carrier_loss();
+    int16_t dmr_filter(int16_t sample);
+    SyncPatternId decode_sync_string(const char* sync_chars) const;
+    uint8_t voice_slot(SyncPatternId voice) const;
+    void emit_burst(const uint8_t* burst_bytes);
+    void emit_call_event(CallEvent event);
+    static bool ends_voice(SyncPatternId voice, SyncPatternId data);
+
+    uint8_t channel_{0};
+    BurstHandler burst_handler_{nullptr};
+    void* burst_context_{nullptr};
+    CallEventHandler call_event_handler_{nullptr};
+    void* call_event_context_{nullptr};
+
+    uint32_t live_total_bursts_{0};
+    Parse_State parseState_{Parse_State_Search_Sync};
+
+    // Voice processing state
+    uint8_t active_burst_index_{0};
+    uint64_t current_burst_start_absolute_{0};
+    uint64_t current_burst_start_sample_{0};
+    SyncPatternId current_burst_sync_{SyncPatternId::Unknown};
+    uint8_t current_burst_slot_{0};
+    SyncPatternId last_voice_sync_{SyncPatternId::Unknown};  // Unknown once the call has been ended
+
+    std::array<uint8_t, DIBIT_BUF_SIZE> dibit_buf_{};
+    size_t dibit_buf_index_{0};
+    uint8_t voice_dibits_[108]{};
+    size_t dibit_index_{0};
+    uint32_t sync_search_symbol_count_{0};
+    bool carrier_present_{true};
+    uint64_t symbol_counter_{0};
+    uint64_t absolute_sample_index_{0};
+    std::array<char, kSyncHistorySize> sync_history_{};
+    size_t sync_history_pos_{0};
+    size_t sync_history_count_{0};
+    int data_sync_hold_symbols_{263};
+
+    // Level tracking buffers (24-symbol window)
+    int32_t lbuf1_[24]{};
+    int32_t lbuf2_[24]{};
+    int lbuf1_pos_{0};
+    int32_t lmin_{0};
+    int32_t lmax_{0};
+
+    // RRC filter delay line (raw input samples)
+    int16_t dmr_v_[kDmrNZeros + 1]{};
+
+    std::array<int32_t, kSymbolSamples> symbol_samples_{};
+    int current_symbol_sum_{0};
+    int current_symbol_count_{0};
+    int jitter_{-1};
+    bool jitter_enabled_{false};
+    bool dmr_filter_enabled_{false};
+
+    int center_{0};                   // Adaptive threshold center (like dsd.test)
+    int umid_{0};                     // Upper mid threshold (like dsd.test)
+    int lmid_{0};                     // Lower mid threshold (like dsd.test)
+    int32_t max_sample_{15000};
+    int32_t min_sample_{-15000};
+    int32_t max_ref_{12000};
+    int32_t min_ref_{-12000};
+    int32_t last_filtered_sample_{0};
+    int symbol_center_{4};
+
+    // Samples not yet consumed by the slicer, followed by new input
+    std::array<int16_t, kMinSymbolSamples + kWorkChunk> work_{};
+    size_t work_count_{0};
+
+    uint32_t stats_drop_filtered_{0};
+    uint32_t stats_drop_slot_color_{0};
+    uint32_t stats_sync_hits_ts1_{0};
+};
+
+#endif /*__DMR_SYMBOL_CORE_H__*/
@@ -0,0 +1,42 @@
+/*
+ * Copyright (C) 2025 comparchitect (https://github.com/comparchitect)
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "dsd_rx_chain.hpp"
+
+void DSDRxChain::configure() {
+    // DMR chain: 3.072 MHz -> 384 kHz -> 48 kHz (SPS ≈ 10)
+    decim_0.set<dsp::decimate::FIRC8xR16x24FS4Decim8>().configure(taps_dmr_decim_0.taps);
+    decim_1.set<dsp::decimate::FIRC16xR16x32Decim8>().configure(taps_dmr_decim_1.taps);
+
+    //demod.configure(48000, 6000.0f);
+    demod.configure(kAudioSampleRate, 5000.0f);
+
+    dmr_core_.reset();
+}
+
+buffer_s16_t DSDRxChain::demodulate(const buffer_c8_t& buffer) {
+    // Basic signal processing (decimation, AGC, filtering) - similar to original
+    const auto decim_0_out = decim_0.execute(buffer, dst_buffer);
+    auto decim_1_out = decim_1.execute(decim_0_out, dst_buffer);
+
+    // FM demodulation for symbol processing
+    return demod.execute(decim_1_out, audio_buffer);
+}
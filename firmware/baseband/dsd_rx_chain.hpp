@@ -0,0 +1,134 @@
+/*
+ * Copyright (C) 2025 comparchitect (https://github.com/comparchitect)
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __DSD_RX_CHAIN_H__
+#define __DSD_RX_CHAIN_H__
+
+#include "dsp_decimate.hpp"
+#include "dsp_demodulate.hpp"
+#include "dsp_fir_taps.hpp"
+
+#include "dmr_symbol_core.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <variant>
+
+/* A decimator that just returns the source buffer. */
+class NoopDecim {
+   public:
+    static constexpr int decimation_factor = 1;
+
+    template <typename Buffer>
+    Buffer execute(const Buffer& src, const Buffer&) {
+        return {src.p, src.count, src.sampling_rate};
+    }
+};
+
+/* Decimator wrapper that can hold one of a set of decimators and dispatch at runtime. */
+template <typename... Args>
+class MultiDecimator {
+   public:
+    template <typename Source, typename Destination>
+    Destination execute(
+        const Source& src,
+        const Destination& dst) {
+        return std::visit(
+            [&src, &dst](auto&& arg) -> Destination {
+                return arg.execute(src, dst);
+            },
+            decimator_);
+    }
+
+    size_t decimation_factor() const {
+        return std::visit(
+            [](auto&& arg) -> size_t {
+                return arg.decimation_factor;
+            },
+            decimator_);
+    }
+
+    template <typename Decimator>
+    Decimator& set() {
+        decimator_ = Decimator{};
+        return std::get<Decimator>(decimator_);
+    }
+
+   private:
+    std::variant<Args...> decimator_{};
+};
+
+/* The DSD RX signal chain from baseband IQ to voice bursts:
+ * 3.072 MHz C8 -> 384 kHz -> 48 kHz (SPS ~ 10) -> FM demod -> DMRSymbolCore.
+ * Has no dependency on the baseband thread, shared memory or audio output,
+ * so the host replay tool runs exactly the code the M4 runs. */
+class DSDRxChain {
+   public:
+    static constexpr size_t kInputSampleRate{3072000};
+    static constexpr size_t kAudioSampleRate{48000};
+
+    void configure();
+
+    /* Decimates and FM-demodulates one baseband block. The result points
+     * into the chain's own buffer and is valid until the next call. */
+    buffer_s16_t demodulate(const buffer_c8_t& buffer);
+
+    /* demodulate() followed by symbol recovery on the result. */
+    void execute(const buffer_c8_t& buffer) {
+        const auto audio_out = demodulate(buffer);
+        dmr_core_.process(audio_out.p, audio_out.count);
+    }
+
+    DMRSymbolCore& core() { return dmr_core_; }
+    const DMRSymbolCore& core() const { return dmr_core_; }
+
+   private:
+    static constexpr uint16_t MAX_BUFFER_SIZE{512};
+
+    std::array<complex16_t, MAX_BUFFER_SIZE> dst{};
+    const buffer_c16_t dst_buffer{
+        dst.data(),
+        dst.size()};
+
+    dsp::demodulate::FM demod{};
+
+    // Audio processing for FM demodulation (must hold an entire decimated block)
+    std::array<int16_t, MAX_BUFFER_SIZE> audio{};
+    const buffer_s16_t audio_buffer{
+        audio.data(),
+        audio.size()};
+
+    MultiDecimator<
+        dsp::decimate::FIRC8xR16x24FS4Decim4,
+        dsp::decimate::FIRC8xR16x24FS4Decim8>
+        decim_0{};
+    MultiDecimator<
+        dsp::decimate::FIRC16xR16x16Decim2,
+        dsp::decimate::FIRC16xR16x32Decim8,
+        NoopDecim>
+        decim_1{};
+
+    // Symbol recovery, sync and burst assembly
+    DMRSymbolCore dmr_core_{};
+};
+
+#endif /*__DSD_RX_CHAIN_H__*/
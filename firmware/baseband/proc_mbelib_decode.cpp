@@ -9,6 +9,7 @@
 #include "audio_dma.hpp"
 #include "message.hpp"
 #include "apps/ambe_processing.hpp"
+#include "apps/mbe_rng.hpp"
 
 #include <array>
 #include <cstdint>
@@ -31,6 +32,11 @@ void unpack_frame(const uint8_t* packed, char ambe_fr[4][24]) {
     }
 }
 
+// Stream mode audio pump. Runs above the event loop so a slow vocoder frame
+// never starves the DMA; it sleeps between polls, so it costs nothing when
+// the ring is idle.
+WORKING_AREA(audio_pump_wa, 512);
+
 }  // namespace
 
 void MBELIBDecodeProcessor::execute(const buffer_c8_t&) {
@@ -47,6 +53,10 @@ void MBELIBDecodeProcessor::on_message(const Message* const message) {
             handle_frame(*reinterpret_cast<const AMBE2DecodeFrameMessage*>(message));
             break;
 
+        case Message::ID::AMBEPCMFrame:
+            handle_playback(*reinterpret_cast<const AMBEPCMFrameMessage*>(message));
+            break;
+
         default:
             break;
     }
@@ -56,61 +66,73 @@ void MBELIBDecodeProcessor::handle_control(const AMBE2DecodeControlMessage& mess
     switch (message.command) {
         case AMBE2DecodeControlMessage::Command::Reset:
             decoder_.reset();
+            // mbelib's random phases restart as in a freshly loaded image,
+            // so a batch that keeps the baseband decodes every file alike
+            mbe_rng_seed(MBE_RNG_SEED);
             frames_processed_ = 0;
             frame_errors_ = 0;
             pcm_dropped_ = 0;
-            // Reset AGC state
-            agc_gain_ = 50.0f;
-            agc_max_history_.fill(0.0f);
-            agc_max_history_index_ = 0;
+            agc_.reset();
+            upsampler_.reset();
+            wav_rate_ = (message.output_rate == mbelib_audio::kDecodeSampleRate) ? mbelib_audio::kDecodeSampleRate
+                                                                                : mbelib_audio::kPlaybackSampleRate;
+            wav_encoder_.reset(static_cast<mbelib_audio::WavFormat>(message.output_format));
+            wav_slot_ = 0;
+            quiet_.reset();
+            streaming_ = false;
+            stop_pending_ = false;
             send_stats(true);
             break;
 
+        case AMBE2DecodeControlMessage::Command::Stream:
+            start_stream();
+            break;
+
         case AMBE2DecodeControlMessage::Command::Flush:
             send_stats(true);
             break;
 
         case AMBE2DecodeControlMessage::Command::Stop:
-            // Send completion acknowledgment to M0
-            AMBE2DecodeStatsMessage completion_message{
-                frames_processed_,
-                frame_errors_,
-                pcm_dropped_,
-                true};  // completion_ack = true
-            shared_memory.application_queue.push(completion_message);
+            if (streaming_) {
+                // The pump acknowledges once the last sample has been played
+                stop_pending_ = true;
+            } else {
+                send_wav_tail();
+                send_completion();
+            }
             break;
     }
 }
 
-void MBELIBDecodeProcessor::handle_frame(const AMBE2DecodeFrameMessage& message) {
-    char ambe_fr[4][24];
-    uint8_t errs2 = ambe_processing::unpack_frame(message.data, ambe_fr);
-
-    // Extract AMBE data directly without re-applying error correction
-    // (ECC was already applied during capture in AMBE app)
-    char ambe_d[49] = {0};
-    ambe_processing::extract_ambe_data(ambe_fr, ambe_d);
+void MBELIBDecodeProcessor::send_completion() {
+    AMBE2DecodeStatsMessage completion_message{
+        frames_processed_,
+        frame_errors_,
+        pcm_dropped_,
+        true,  // completion_ack = true
+        quiet_.skipped()};
+    shared_memory.application_queue.push(completion_message);
+}
 
-    std::array<float, 160> float_pcm{};
-    // Use the stored errs2 from capture to match dsd.test's error handling
-    const int produced = decoder_.processDataFloat(ambe_d, 0, errs2, float_pcm.data(), float_pcm.size());
-    if (produced > 0) {
-        // Apply sophisticated AGC (dsd.test style)
-        apply_auto_gain(float_pcm.data(), produced);
-
-        // Convert to int16_t for M0 processing (upsampling/smoothing will be done there)
-        std::array<int16_t, 160> int16_buffer{};
-        for (size_t i = 0; i < produced; ++i) {
-            float sample = float_pcm[i];
-            if (sample > 32767.0f) sample = 32767.0f;
-            if (sample < -32768.0f) sample = -32768.0f;
-            int16_buffer[i] = static_cast<int16_t>(sample);
+void MBELIBDecodeProcessor::handle_frame(const AMBE2DecodeFrameMessage& message) {
+    // AGC, int16 conversion, upsampling and WAV encoding all run here
+    std::array<int16_t, mbelib_audio::kFrameSamples> int16_buffer{};
+    // Erasure runs skip the vocoder after their first frame (see QuietSkip)
+    const size_t produced = mbelib_audio::decode_frame(decoder_, agc_, quiet_, message.data, int16_buffer.data());
+    if (streaming_) {
+        if (produced > 0) {
+            stream_frame(int16_buffer.data(), produced);
+        } else {
+            ++frame_errors_;
         }
+        ++frames_processed_;
+        ack_stream_frame();
+        send_stats();
+        return;
+    }
 
-        AMBEPCMFrameMessage pcm_message{int16_buffer.data(), static_cast<uint16_t>(produced)};
-        if (!shared_memory.application_queue.push(pcm_message)) {
-            ++pcm_dropped_;
-        }
+    if (produced > 0) {
+        send_wav_frame(int16_buffer.data(), produced);
     } else {
         ++frame_errors_;
     }
@@ -120,6 +142,60 @@ void MBELIBDecodeProcessor::handle_frame(const AMBE2DecodeFrameMessage& message)
     send_stats();
 }
 
+uint8_t* MBELIBDecodeProcessor::next_wav_slot() {
+    uint8_t* slot = wav_slots_[wav_slot_].data();
+    wav_slot_ = (wav_slot_ + 1) % kWavSlots;
+    return slot;
+}
+
+void MBELIBDecodeProcessor::send_wav_frame(const int16_t* pcm, size_t count) {
+    const int16_t* samples = pcm;
+    size_t sample_count = count;
+    if (wav_rate_ != mbelib_audio::kDecodeSampleRate) {
+        sample_count = upsampler_.process(pcm, count, upsampled_.data());
+        samples = upsampled_.data();
+    }
+
+    uint8_t* slot = next_wav_slot();
+    size_t byte_count = sample_count * sizeof(int16_t);
+    if (wav_encoder_.format() == mbelib_audio::WavFormat::Pcm16) {
+        std::memcpy(slot, samples, byte_count);
+    } else {
+        byte_count = wav_encoder_.encode(samples, sample_count, slot);
+    }
+
+    AMBEWavDataMessage wav_message{slot, static_cast<uint16_t>(byte_count), static_cast<uint16_t>(sample_count), true};
+    if (!shared_memory.application_queue.push(wav_message)) {
+        ++pcm_dropped_;
+    }
+}
+
+void MBELIBDecodeProcessor::send_wav_tail() {
+    // Completes the last ADPCM block; queued ahead of the completion ack,
+    // so the M0 has written it before it finalises the header
+    uint8_t* slot = next_wav_slot();
+    const size_t byte_count = wav_encoder_.flush(slot);
+    if (byte_count == 0) {
+        return;
+    }
+    AMBEWavDataMessage tail_message{slot, static_cast<uint16_t>(byte_count), 0, false};
+    if (!shared_memory.application_queue.push(tail_message)) {
+        ++pcm_dropped_;
+    }
+}
+
+void MBELIBDecodeProcessor::handle_playback(const AMBEPCMFrameMessage& message) {
+    // WAV playback: the M0 has already brought the file to the 12 kHz codec rate
+    if (!streaming_) {
+        return;
+    }
+
+    stream_samples(message.samples, message.sample_count);
+    ++frames_processed_;
+    ack_stream_frame();
+    send_stats();
+}
+
 void MBELIBDecodeProcessor::send_stats(bool force) {
     if (!force && (frames_processed_ % 25u != 0u)) {
         return;
@@ -129,69 +205,136 @@ void MBELIBDecodeProcessor::send_stats(bool force) {
         frames_processed_,
         frame_errors_,
         pcm_dropped_,
-        false};  // completion_ack
+        false,  // completion_ack
+        quiet_.skipped()};
     shared_memory.application_queue.push(stats_message);
 
     RequestSignalMessage progress_message{RequestSignalMessage::Signal::AmbeDecodeProgress};
     shared_memory.application_queue.push(progress_message);
 }
 
-void MBELIBDecodeProcessor::apply_auto_gain(float* samples, size_t count) {
-    if (!samples || count == 0) {
-        return;
+void MBELIBDecodeProcessor::start_stream() {
+    streaming_ = true;
+    stop_pending_ = false;
+    upsampler_.reset();
+    ring_read_ = 0;
+    ring_write_ = 0;
+    acks_owed_ = 0;
+
+    if (pump_thread_ == nullptr) {
+        pump_thread_ = chThdCreateStatic(audio_pump_wa, sizeof(audio_pump_wa),
+                                         NORMALPRIO + 10, MBELIBDecodeProcessor::audio_pump_fn, this);
+    }
+}
+
+void MBELIBDecodeProcessor::stream_frame(const int16_t* pcm, size_t count) {
+    // Same 48 kHz signal the WAV gets, taken at every 4th sample: the
+    // interpolator's 4 kHz cut already band-limits it for 12 kHz.
+    const size_t upsampled = upsampler_.process(pcm, count, upsampled_.data());
+
+    size_t decimated = 0;
+    for (size_t i = 0; i < upsampled; i += kStreamDecimation) {
+        upsampled_[decimated++] = upsampled_[i];
     }
+    stream_samples(upsampled_.data(), decimated);
+}
 
-    // Detect max level (dsd.test style)
-    float max_val = 0.0f;
+void MBELIBDecodeProcessor::stream_samples(const int16_t* samples, size_t count) {
+    size_t write = ring_write_.load(std::memory_order_relaxed);
+    const size_t read = ring_read_.load(std::memory_order_acquire);
     for (size_t i = 0; i < count; ++i) {
-        const float abs_val = std::fabs(samples[i]);
-        if (abs_val > max_val) {
-            max_val = abs_val;
+        if (write - read >= kStreamRingSamples) {
+            break;  // Cannot happen while the M0 honours the acks
         }
+        stream_ring_[write % kStreamRingSamples] = samples[i];
+        ++write;
     }
+    ring_write_.store(write, std::memory_order_release);
+}
 
-    // Store in history buffer
-    agc_max_history_[agc_max_history_index_] = max_val;
-    agc_max_history_index_ = (agc_max_history_index_ + 1) % agc_max_history_.size();
-
-    // Find max across history
-    float max_history = 0.0f;
-    for (float hist_val : agc_max_history_) {
-        if (hist_val > max_history) {
-            max_history = hist_val;
-        }
+void MBELIBDecodeProcessor::ack_stream_frame() {
+    // The ack is what lets the M0 send the next frame; hold it while the
+    // ring is full so reading paces itself to playback.
+    if (stream_has_room()) {
+        send_frame_ack();
+    } else {
+        ++acks_owed_;
     }
+}
+
+size_t MBELIBDecodeProcessor::stream_level() const {
+    return ring_write_.load(std::memory_order_acquire) - ring_read_.load(std::memory_order_acquire);
+}
 
-    // Determine optimal gain level (dsd.test algorithm)
-    float gainfactor = 50.0f;  // Default gain
-    if (max_history > 0.0f) {
-        gainfactor = 30000.0f / max_history;
+bool MBELIBDecodeProcessor::stream_has_room() const {
+    return stream_level() < kStreamTargetSamples;
+}
+
+void MBELIBDecodeProcessor::send_frame_ack() {
+    // A PCM frame with no samples: the M0 only retires an in-flight frame
+    AMBEPCMFrameMessage ack_message{nullptr, 0};
+    shared_memory.application_queue.push(ack_message);
+}
+
+void MBELIBDecodeProcessor::fill_audio_buffer(const audio::buffer_t& audio_buffer) {
+    const size_t write = ring_write_.load(std::memory_order_acquire);
+    size_t read = ring_read_.load(std::memory_order_relaxed);
+
+    if (!audio_started_ && ((write - read) >= kStreamPrebufferSamples || stop_pending_)) {
+        audio_started_ = true;
     }
 
-    float gaindelta = 0.0f;
-    if (gainfactor < agc_gain_) {
-        // Immediate gain reduction
-        agc_gain_ = gainfactor;
-    } else {
-        // Gradual gain increase
-        if (gainfactor > 50.0f) {
-            gainfactor = 50.0f;
+    bool underrun = false;
+    for (size_t i = 0; i < audio_buffer.count; ++i) {
+        int16_t sample = 0;
+        if (audio_started_ && read != write) {
+            sample = stream_ring_[read % kStreamRingSamples];
+            ++read;
+        } else if (audio_started_) {
+            underrun = true;
         }
-        gaindelta = gainfactor - agc_gain_;
-        if (gaindelta > (0.05f * agc_gain_)) {
-            gaindelta = 0.05f * agc_gain_;
+        audio_buffer.p[i].left = audio_buffer.p[i].right = sample;
+    }
+    ring_read_.store(read, std::memory_order_release);
+
+    if (underrun) {
+        // Rebuild the prebuffer rather than stutter sample by sample
+        audio_started_ = false;
+        if (!stop_pending_) {
+            ++pcm_dropped_;
         }
     }
 
-    gaindelta /= static_cast<float>(count);
+    while ((acks_owed_ > 0) && stream_has_room()) {
+        --acks_owed_;
+        send_frame_ack();
+    }
 
-    // Apply gain with smooth transitions
-    for (size_t i = 0; i < count; ++i) {
-        const float current_gain = agc_gain_ + static_cast<float>(i) * gaindelta;
-        samples[i] *= current_gain;
+    if (stop_pending_ && (acks_owed_ == 0) && (stream_level() == 0)) {
+        stop_pending_ = false;
+        send_completion();
+    }
+}
+
+void MBELIBDecodeProcessor::run_audio_pump() {
+    const void* last_buffer = nullptr;
+    while (true) {
+        if (streaming_) {
+            // A new empty buffer appears once per DMA transfer
+            const auto audio_buffer = audio::dma::tx_empty_buffer();
+            if (audio_buffer.p != last_buffer) {
+                last_buffer = audio_buffer.p;
+                fill_audio_buffer(audio_buffer);
+            }
+        }
+        chThdSleepMilliseconds(1);
     }
+}
 
-    agc_gain_ += static_cast<float>(count) * gaindelta;
+msg_t MBELIBDecodeProcessor::audio_pump_fn(void* arg) {
+    chRegSetThreadName("mbelib_audio");
+    static_cast<MBELIBDecodeProcessor*>(arg)->run_audio_pump();
+    return 0;
 }
 
 int main() {
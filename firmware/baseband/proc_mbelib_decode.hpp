@@ -7,10 +7,15 @@
 
 #include "baseband_processor.hpp"
 #include "message.hpp"
+#include "audio_dma.hpp"
 
 #include "external/dsd/mbe_decoder.hpp"
+#include "apps/mbelib_audio.hpp"
+
+#include "ch.h"
 
 #include <array>
+#include <atomic>
 #include <cstdint>
 #include <cstddef>
 
@@ -22,18 +27,67 @@ class MBELIBDecodeProcessor : public BasebandProcessor {
    private:
     void handle_control(const AMBE2DecodeControlMessage& message);
     void handle_frame(const AMBE2DecodeFrameMessage& message);
+    void handle_playback(const AMBEPCMFrameMessage& message);
     void send_stats(bool force = false);
-    void apply_auto_gain(float* samples, size_t count);
+    void send_completion();
+
+    // WAV decode: frames leave the M4 at the WAV rate and encoding. Each
+    // goes into a slot the M0 reads in place and writes to the SD card;
+    // with one slot more than frames in flight, a slot is only rewritten
+    // after the M0 has retired the frame it held.
+    static constexpr size_t kWavSlots = mbelib_audio::kMaxFramesInFlight + 1;
+    static constexpr size_t kWavSlotBytes =
+        mbelib_audio::WavEncoder::max_encoded_bytes(mbelib_audio::kUpsampledFrameSamples);
+
+    void send_wav_frame(const int16_t* pcm, size_t count);
+    void send_wav_tail();
+    uint8_t* next_wav_slot();
+
+    // Decode-to-speaker ("Play .ambe") and WAV playback: PCM goes to the
+    // audio DMA at 12 kHz through a jitter ring instead of back to the M0.
+    static constexpr size_t kStreamDecimation = 4;  // 48 kHz -> 12 kHz codec rate
+    static constexpr size_t kStreamFrameSamples = mbelib_audio::kUpsampledFrameSamples / kStreamDecimation;
+    static constexpr size_t kStreamRingSamples = 4096;                   // ~340 ms
+    static constexpr size_t kStreamPrebufferSamples = 2 * kStreamFrameSamples;  // 40 ms before first output
+    static constexpr size_t kStreamTargetSamples = 8 * kStreamFrameSamples;     // Ack frames while below ~160 ms
+
+    void start_stream();
+    void stream_frame(const int16_t* pcm, size_t count);
+    void stream_samples(const int16_t* samples, size_t count);
+    void ack_stream_frame();
+    size_t stream_level() const;
+    bool stream_has_room() const;
+    void send_frame_ack();
+    void fill_audio_buffer(const audio::buffer_t& audio_buffer);
+    void run_audio_pump();
+    static msg_t audio_pump_fn(void* arg);
 
     mbe::MBEDecoder decoder_{};
     uint32_t frames_processed_{0};
     uint32_t frame_errors_{0};
-    uint32_t pcm_dropped_{0};
+    uint32_t pcm_dropped_{0};  // In stream mode: audio underruns
+
+    mbelib_audio::AutoGain agc_{};
+    mbelib_audio::QuietSkip quiet_{};
+
+    bool streaming_{false};
+    mbelib_audio::Upsampler upsampler_{};
+    std::array<int16_t, mbelib_audio::kUpsampledFrameSamples> upsampled_{};
+
+    uint32_t wav_rate_{mbelib_audio::kPlaybackSampleRate};
+    mbelib_audio::WavEncoder wav_encoder_{};
+    alignas(4) std::array<std::array<uint8_t, kWavSlotBytes>, kWavSlots> wav_slots_{};
+    size_t wav_slot_{0};
+
+    // Single producer (event loop) / single consumer (pump thread)
+    std::array<int16_t, kStreamRingSamples> stream_ring_{};
+    std::atomic<size_t> ring_write_{0};
+    std::atomic<size_t> ring_read_{0};
+    std::atomic<uint32_t> acks_owed_{0};
+    std::atomic<bool> stop_pending_{false};
+    bool audio_started_{false};  // Pump thread only
 
-    // Sophisticated AGC state (dsd.test style)
-    float agc_gain_{50.0f};  // Start with gain = 50
-    std::array<float, 25> agc_max_history_{};
-    size_t agc_max_history_index_{0};
+    Thread* pump_thread_{nullptr};
 };
 
 #endif /* __PROC_MBELIB_DECODE_HPP__ */
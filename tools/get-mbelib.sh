@@ -20,12 +20,80 @@ mkdir -p "${WORK_DIR}/src"
 cp "${WORK_DIR}/mbelib"/{mbelib.c,mbelib.h,mbelib_const.h} "${WORK_DIR}/src/"
 cp -r "${WORK_DIR}/mbelib"/*.c "${WORK_DIR}/src/" || true
 
+# mbelib draws its random phases from the process-wide rand(). Route them
+# through apps/mbe_rng.hpp, so each decode starts from the same seed as a
+# fresh PA2D image and host threads do not share one sequence.
+echo "Routing rand() through apps/mbe_rng.hpp..."
+for src in "${WORK_DIR}/src"/*.c; do
+	if grep -Eq '\<s?rand *\(' "${src}"; then
+		sed -i -E -e 's/\<rand *\(\)/mbe_rng_next ()/g' -e 's/\<srand *\(/mbe_rng_seed (/g' \
+			-e '1i #include "apps/mbe_rng.hpp"' "${src}"
+	fi
+done
+if grep -Eq '\<rand *\(' "${WORK_DIR}/src"/*.c; then
+	echo "rand() calls left in mbelib; update the patch above" >&2
+	exit 1
+fi
+
+# Keep the unpatched (rand-routed) sources for the ambe2wav_ref A/B build.
+cp -r "${WORK_DIR}/src" "${WORK_DIR}/src_ref"
+
+# Comfort-noise fast path. Each unvoiced band sums a multisine of cosf()
+# terms per sample, then scales the sum by the synthesis window Ws[],
+# which is zero for about a third of each frame. Skip the cosf() where the
+# window is zero; the product is zero either way and every mbe_rng_next()
+# draw is still made, so the output is bit-exact. Silence frames are all
+# unvoiced and gain the most.
+echo "Gating unvoiced cosf() on the synthesis window..."
+awk '
+{ line[NR] = $0 }
+END {
+	gated = 0
+	for (i = 1; i <= NR; i++) {
+		if (!match(line[i], /C[0-9]+ *= *C[0-9]+ *\+ *cosf *\(/) || index(line[i], "mbe_rng_next") ||
+		    line[i] !~ /\) *; *$/) {
+			continue
+		}
+		acc = substr(line[i], RSTART, RLENGTH)
+		sub(/ *=.*/, "", acc)
+		for (j = i + 1; j <= NR && j <= i + 12; j++) {
+			if (line[j] ~ ("^[ \t]*" acc " *= *" acc " *\\* *uvsine *\\* *Ws\\[[^]]+\\]")) {
+				w = substr(line[j], index(line[j], "Ws["))
+				w = substr(w, 1, index(w, "]"))
+				head = substr(line[i], 1, index(line[i], "cosf") - 1)
+				call = substr(line[i], index(line[i], "cosf"))
+				sub(/ *; *$/, "", call)
+				line[i] = head "((" w " == 0) ? 0 : " call ");"
+				++gated
+				break
+			}
+		}
+	}
+	for (i = 1; i <= NR; i++) {
+		print line[i]
+	}
+	print gated > count
+}' count="${WORK_DIR}/gated.count" "${WORK_DIR}/src/mbelib.c" >"${WORK_DIR}/mbelib.c.gated"
+GATED="$(cat "${WORK_DIR}/gated.count")"
+rm -f "${WORK_DIR}/gated.count"
+if [ "${GATED}" -gt 0 ]; then
+	mv "${WORK_DIR}/mbelib.c.gated" "${WORK_DIR}/src/mbelib.c"
+	echo "Gated ${GATED} unvoiced cosf() sums"
+else
+	rm -f "${WORK_DIR}/mbelib.c.gated"
+	echo "warning: no unvoiced cosf() sums found; mbelib left ungated" >&2
+fi
+
 cat >"${WORK_DIR}/README.txt" <<'EOF'
 This folder contains mbelib sources fetched locally by tools/get-mbelib.sh.
 They are NOT redistributed with the firmware. Use them only for local builds/testing.
 
 To enable mbelib for MBELIB:
 - Add these sources to the MBELIB baseband build (proc_mbelib_decode) and define WITH_MBELIB=1.
+- rand() has been replaced by mbe_rng_next() (firmware/application/apps/mbe_rng.cpp,
+  already in the PA2D and ambe2wav sources); keep firmware/application on the include path.
+- src/ skips unvoiced cosf() terms where the synthesis window is zero (bit-exact);
+  src_ref/ is the same without that patch, for tools/host's ambe2wav_ref A/B build.
 - Rebuild the external MBELIB baseband (mbelib_decode.m4b) and MBELIB.ppma.
 - Do not redistribute mbelib without complying with its license.
 EOF
@@ -0,0 +1,207 @@
+/*
+ * Copyright (C) 2025 comparchitect (https://github.com/comparchitect)
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Checks the fused MBELIB AGC kernel against the original.
+ *
+ * "legacy" is AutoGain as it was before the max-deque: a 25-entry history
+ * rescanned every frame, the float gain ramp in place, then to_int16().
+ * "fused" is AutoGain::apply_to_int16(). Both run over the same vocoder-like
+ * float frames (speech bursts at varying levels, silence and near-silence
+ * runs, isolated peaks); the tool reports the largest output difference in
+ * LSB and host time per frame, and fails if any sample is more than 1 LSB
+ * off. Built with MBELIB_AUDIO_DSP, so the SSAT kernel is the one checked. */
+
+#include "apps/mbelib_audio.hpp"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+namespace {
+
+using mbelib_audio::kFrameSamples;
+
+constexpr double kPi = 3.14159265358979323846;
+
+/* The pre-deque AutoGain, kept verbatim for comparison. */
+class LegacyAutoGain {
+   public:
+    void apply(float* samples, size_t count) {
+        float max_val = 0.0f;
+        for (size_t i = 0; i < count; ++i) {
+            const float abs_val = std::fabs(samples[i]);
+            if (abs_val > max_val) {
+                max_val = abs_val;
+            }
+        }
+
+        max_history_[max_history_index_] = max_val;
+        max_history_index_ = (max_history_index_ + 1) % max_history_.size();
+
+        float max_history = 0.0f;
+        for (float hist_val : max_history_) {
+            if (hist_val > max_history) {
+                max_history = hist_val;
+            }
+        }
+
+        float gainfactor = 50.0f;
+        if (max_history > 0.0f) {
+            gainfactor = 30000.0f / max_history;
+        }
+
+        float gaindelta = 0.0f;
+        if (gainfactor < gain_) {
+            gain_ = gainfactor;
+        } else {
+            if (gainfactor > 50.0f) {
+                gainfactor = 50.0f;
+            }
+            gaindelta = gainfactor - gain_;
+            if (gaindelta > (0.05f * gain_)) {
+                gaindelta = 0.05f * gain_;
+            }
+        }
+        gaindelta /= static_cast<float>(count);
+
+        for (size_t i = 0; i < count; ++i) {
+            const float current_gain = gain_ + static_cast<float>(i) * gaindelta;
+            samples[i] *= current_gain;
+        }
+        gain_ += static_cast<float>(count) * gaindelta;
+    }
+
+   private:
+    float gain_{50.0f};
+    std::array<float, 25> max_history_{};
+    size_t max_history_index_{0};
+};
+
+/* Frames shaped like mbelib output: harmonic bursts whose level wanders
+ * over 40 dB, with silence and low-level runs in between, so the history
+ * window both rises and decays through every branch of the gain logic. */
+std::vector<float> make_input(size_t frames) {
+    std::mt19937 rng{7};
+    std::uniform_real_distribution<float> unit{0.0f, 1.0f};
+    std::normal_distribution<float> noise{0.0f, 1.0f};
+    std::vector<float> samples(frames * kFrameSamples, 0.0f);
+
+    float level = 1000.0f;
+    float phase = 0.0f;
+    for (size_t f = 0; f < frames; ++f) {
+        float* frame = samples.data() + f * kFrameSamples;
+        const float choice = unit(rng);
+        if (choice < 0.15f) {
+            continue;  // Silence
+        }
+        if (choice < 0.25f) {
+            for (size_t n = 0; n < kFrameSamples; ++n) {
+                frame[n] = 0.5f * noise(rng);
+            }
+            continue;
+        }
+
+        level *= std::pow(10.0f, (unit(rng) - 0.5f) * 0.4f);
+        level = std::min(30000.0f, std::max(10.0f, level));
+        const float w0 = 2.0f * static_cast<float>(kPi) * (90.0f + 150.0f * unit(rng)) / 8000.0f;
+        for (size_t n = 0; n < kFrameSamples; ++n) {
+            float value = 0.0f;
+            for (int h = 1; h <= 6; ++h) {
+                value += std::cos(phase * static_cast<float>(h)) / static_cast<float>(h);
+            }
+            frame[n] = level * 0.4f * value + 0.01f * level * noise(rng);
+            phase += w0;
+        }
+        phase = std::fmod(phase, 2.0f * static_cast<float>(kPi));
+        if (choice > 0.97f) {
+            frame[kFrameSamples / 2] = level * 8.0f;  // Isolated peak
+        }
+    }
+    return samples;
+}
+
+std::vector<int16_t> run_legacy(const std::vector<float>& input) {
+    LegacyAutoGain agc{};
+    std::vector<float> work = input;
+    std::vector<int16_t> output(input.size());
+    for (size_t f = 0; f < input.size() / kFrameSamples; ++f) {
+        float* frame = work.data() + f * kFrameSamples;
+        agc.apply(frame, kFrameSamples);
+        mbelib_audio::to_int16(frame, output.data() + f * kFrameSamples, kFrameSamples);
+    }
+    return output;
+}
+
+std::vector<int16_t> run_fused(const std::vector<float>& input) {
+    mbelib_audio::AutoGain agc{};
+    agc.reset();
+    std::vector<int16_t> output(input.size());
+    for (size_t f = 0; f < input.size() / kFrameSamples; ++f) {
+        agc.apply_to_int16(input.data() + f * kFrameSamples, kFrameSamples, output.data() + f * kFrameSamples);
+    }
+    return output;
+}
+
+template <typename Fn>
+double ns_per_frame(Fn fn, const std::vector<float>& input) {
+    constexpr int kRepeats = 5;
+    double best = 0.0;
+    for (int r = 0; r < kRepeats; ++r) {
+        const auto t0 = std::chrono::steady_clock::now();
+        const auto output = fn(input);
+        const auto t1 = std::chrono::steady_clock::now();
+        const double ns = std::chrono::duration<double, std::nano>(t1 - t0).count() /
+                          static_cast<double>(input.size() / kFrameSamples);
+        best = (r == 0) ? ns : std::min(best, ns);
+        if (output.empty()) {
+            std::abort();
+        }
+    }
+    return best;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    const size_t frames = (argc > 1) ? static_cast<size_t>(std::max(1, std::atoi(argv[1]))) : 20000;
+    const auto input = make_input(frames);
+
+    const auto legacy = run_legacy(input);
+    const auto fused = run_fused(input);
+    int worst = 0;
+    size_t differing = 0;
+    for (size_t i = 0; i < legacy.size(); ++i) {
+        const int diff = std::abs(static_cast<int>(legacy[i]) - static_cast<int>(fused[i]));
+        worst = std::max(worst, diff);
+        differing += (diff != 0) ? 1 : 0;
+    }
+    std::printf("legacy vs fused AGC over %zu frames: max %d LSB, %zu samples differ\n", frames, worst, differing);
+
+    const double legacy_ns = ns_per_frame(run_legacy, input);
+    const double fused_ns = ns_per_frame(run_fused, input);
+    std::printf("host per frame: legacy %.0f ns, fused %.0f ns (%.1fx)\n", legacy_ns, fused_ns, legacy_ns / fused_ns);
+    return (worst <= 1) ? 0 : 1;
+}
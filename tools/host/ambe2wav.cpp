@@ -0,0 +1,961 @@
+/*
+ * Copyright (C) 2025 comparchitect (https://github.com/comparchitect)
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Batch .ambe to .wav conversion.
+ *
+ * Runs the MBELIB decode path (mbe_decoder, AGC, int16 conversion, 6x
+ * upsampling, WAV header) from the shared firmware sources, one decoder per
+ * file, files spread over a pool of threads. Each decoder draws mbelib's
+ * random phases from its own sequence (apps/mbe_rng.hpp), so the thread
+ * count never changes the output. Inputs are mapped with mmap.
+ * Output matches the WAV the MBELIB app writes on the SD card, provided the
+ * device run reported no PCM drops.
+ *
+ * With --split, long files are also cut into segments at runs of silence
+ * or erasure frames and the segments decoded on different threads. Only
+ * the vocoder runs per segment; AGC and upsampling stay sequential.
+ *
+ * v2 files are read through their blocks; --call N decodes just one call,
+ * found through the trailing index (or a block scan if the file was never
+ * closed).
+ *
+ * --follow decodes one capture that is still being written, polling it
+ * for appended frames. */
+
+#include "apps/ambe_log_format.hpp"
+#include "apps/ambe_log_v2.hpp"
+#include "apps/mbe_rng.hpp"
+#include "apps/mbelib_audio.hpp"
+#include "external/dsd/mbe_decoder.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+struct Job {
+    fs::path input;
+    fs::path output;
+};
+
+struct OutputFormat {
+    uint32_t sample_rate{mbelib_audio::kPlaybackSampleRate};
+    mbelib_audio::WavFormat encoding{mbelib_audio::WavFormat::Pcm16};
+};
+
+struct Result {
+    bool ok{false};
+    const char* error{nullptr};
+    uint32_t frames{0};
+    uint32_t frame_errors{0};
+    uint32_t skipped{0};
+    uint32_t segments{0};
+    uint32_t corrupt_blocks{0};
+    uint32_t samples{0};
+    double seconds{0.0};
+};
+
+/* Read-only mapping of a whole input file. */
+class MappedFile {
+   public:
+    explicit MappedFile(const fs::path& path) {
+        const int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return;
+        }
+        struct stat st {};
+        if (::fstat(fd, &st) == 0 && st.st_size > 0) {
+            void* p = ::mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p != MAP_FAILED) {
+                data_ = static_cast<const uint8_t*>(p);
+                size_ = static_cast<size_t>(st.st_size);
+                ::madvise(p, size_, MADV_SEQUENTIAL);
+            }
+        }
+        ::close(fd);
+    }
+
+    ~MappedFile() {
+        if (data_) {
+            ::munmap(const_cast<uint8_t*>(data_), size_);
+        }
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const uint8_t* data() const { return data_; }
+    size_t size() const { return size_; }
+
+   private:
+    const uint8_t* data_{nullptr};
+    size_t size_{0};
+};
+
+// Splitting (--split): segments are cut in the middle of a run of quiet
+// frames and never shorter than a minute of audio. Each segment's decoder
+// starts kWarmupFrames early and discards that output, so by the cut it
+// has the same quiet history the sequential decoder would have.
+constexpr size_t kQuietRunFrames = 8;
+constexpr size_t kWarmupFrames = 25;
+constexpr size_t kMinSegmentFrames = 3000;
+
+struct Segment {
+    size_t warmup_start;
+    size_t first;
+    size_t last;
+};
+
+/* One input file in flight: its mapping, the pre-AGC PCM each segment
+ * worker fills in, and the count of segments still decoding. */
+struct FileTask {
+    explicit FileTask(const Job& job)
+        : input{job.input} {}
+
+    MappedFile input;
+    const uint8_t* frames{nullptr};
+    size_t frame_count{0};
+    std::vector<uint8_t> v2_frames{};  // Frames gathered out of v2 blocks
+    uint32_t corrupt_blocks{0};        // v2 blocks skipped on a bad CRC
+    std::vector<Segment> segments{};
+    std::vector<std::vector<float>> segment_pcm{};  // Frames first..last of each segment
+    std::vector<uint8_t> produced{};
+    std::atomic<uint32_t> skipped{0};
+    std::atomic<size_t> remaining{0};
+};
+
+std::vector<Segment> plan_segments(const uint8_t* frames, size_t frame_count, bool split) {
+    std::vector<Segment> segments{};
+    size_t start = 0;
+
+    if (split && frame_count >= 2 * kMinSegmentFrames) {
+        size_t quiet_run = 0;
+        for (size_t i = 0; i < frame_count; ++i) {
+            const auto kind = mbelib_audio::classify_frame(frames + i * ambe_log::kFrameBytes);
+            quiet_run = mbelib_audio::is_quiet(kind) ? quiet_run + 1 : 0;
+            if (quiet_run < kQuietRunFrames) {
+                continue;
+            }
+
+            const size_t cut = i + 1 - kQuietRunFrames / 2;
+            if ((cut - start >= kMinSegmentFrames) && (frame_count - cut >= kMinSegmentFrames)) {
+                segments.push_back({(start > kWarmupFrames) ? start - kWarmupFrames : 0, start, cut});
+                start = cut;
+            }
+            quiet_run = 0;
+        }
+    }
+
+    segments.push_back({(start > kWarmupFrames) ? start - kWarmupFrames : 0, start, frame_count});
+    return segments;
+}
+
+/* First block of call (0-based) in a v2 file, or kNoBlock. Follows the
+ * index pages back from the trailing one. A file without an index, or
+ * whose page for the call is damaged, is scanned for the first intact
+ * block of the call; that is its start unless the start is corrupt. */
+uint32_t find_v2_call(const uint8_t* data, size_t blocks, const ambe_log::v2::FileHeader& header, uint32_t call) {
+    using namespace ambe_log::v2;
+    uint32_t page_block = header.index_block;
+    for (size_t visited = 0; page_block < blocks && visited < blocks; ++visited) {
+        IndexPage page{};
+        std::memcpy(&page, data + page_block * kBlockBytes, sizeof(page));
+        if (!is_index_page(page, page_block)) {
+            break;
+        }
+        if (call >= page.header.first_call && call - page.header.first_call < page.header.entry_count) {
+            return page.entries[call - page.header.first_call].first_block;
+        }
+        page_block = page.header.previous_page;
+    }
+
+    for (uint32_t b = 1; b < blocks; ++b) {
+        DataBlock block{};
+        std::memcpy(&block, data + b * kBlockBytes, sizeof(block));
+        if (is_data_block(block, b) && block.header.call_id == call) {
+            return b;
+        }
+    }
+    return kNoBlock;
+}
+
+/* Copies the frames of a v2 file, or of one call when call >= 0, into
+ * task.v2_frames. Corrupt blocks are counted and skipped, as on the
+ * device; kMaxCorruptRun of them in a row end the file. */
+const char* gather_v2(FileTask& task, int call) {
+    using namespace ambe_log::v2;
+    const uint8_t* data = task.input.data();
+    const size_t blocks = task.input.size() / kBlockBytes;
+    if (blocks == 0) {
+        return "bad header";
+    }
+    FileHeader header{};
+    std::memcpy(&header, data, sizeof(header));
+    if (!validate(header)) {
+        return "bad header";
+    }
+
+    uint32_t first = 1;
+    if (call >= 0) {
+        first = find_v2_call(data, blocks, header, static_cast<uint32_t>(call));
+        if (first == kNoBlock) {
+            return "no such call";
+        }
+    }
+
+    uint32_t corrupt_run = 0;
+    for (uint32_t b = first; b < blocks; ++b) {
+        DataBlock block{};
+        std::memcpy(&block, data + b * kBlockBytes, sizeof(block));
+        const BlockKind kind = classify_block(block, b);
+        if (kind == BlockKind::Index) {
+            continue;
+        }
+        if (kind == BlockKind::Corrupt) {
+            ++task.corrupt_blocks;
+            if (++corrupt_run == kMaxCorruptRun) {
+                break;
+            }
+            continue;
+        }
+        corrupt_run = 0;
+        if (call >= 0 && block.header.call_id != static_cast<uint32_t>(call)) {
+            break;
+        }
+        const uint8_t* frames = &block.frames[0][0];
+        task.v2_frames.insert(task.v2_frames.end(), frames, frames + block.frame_count() * ambe_log::kFrameBytes);
+        if (call >= 0 && (block.header.flags & kCallEnd)) {
+            break;
+        }
+    }
+    return nullptr;
+}
+
+/* Maps and validates an input and plans its segments. */
+const char* open_task(FileTask& task, bool split, int call) {
+    if (!task.input.data()) {
+        return "open failed";
+    }
+
+    if (ambe_log::v2::is_v2(task.input.data(), task.input.size())) {
+        if (const char* error = gather_v2(task, call)) {
+            return error;
+        }
+        task.frames = task.v2_frames.data();
+        task.frame_count = task.v2_frames.size() / ambe_log::kFrameBytes;
+    } else {
+        if (call >= 0) {
+            return "v1 file has no calls";
+        }
+        if (task.input.size() < sizeof(ambe_log::Header)) {
+            return "open failed";
+        }
+
+        ambe_log::Header header{};
+        std::memcpy(&header, task.input.data(), sizeof(header));
+        if (!ambe_log::validate(header)) {
+            return "bad header";
+        }
+
+        // The device gives up on a truncated trailing frame; so do we
+        const size_t payload = task.input.size() - sizeof(header);
+        if (payload % ambe_log::kFrameBytes != 0) {
+            return "partial frame";
+        }
+        task.frames = task.input.data() + sizeof(header);
+        task.frame_count = payload / ambe_log::kFrameBytes;
+    }
+
+    task.segments = plan_segments(task.frames, task.frame_count, split);
+    task.segment_pcm.resize(task.segments.size());
+    task.produced.resize(task.frame_count);
+    task.remaining = task.segments.size();
+    return nullptr;
+}
+
+void decode_segment(FileTask& task, size_t index) {
+    const Segment& segment = task.segments[index];
+    std::vector<float>& segment_pcm = task.segment_pcm[index];
+    segment_pcm.resize((segment.last - segment.first) * mbelib_audio::kFrameSamples);
+
+    // Fresh state per segment, as after AMBE2DecodeControl Reset on the M4;
+    // the random phases come from this thread's own seeded sequence
+    auto decoder = std::make_unique<mbe::MBEDecoder>();
+    decoder->reset();
+    mbe_rng_seed(MBE_RNG_SEED);
+    mbelib_audio::QuietSkip quiet{};
+
+    std::array<float, mbelib_audio::kFrameSamples> discard{};
+    uint32_t warmup_skipped = 0;
+    for (size_t i = segment.warmup_start; i < segment.last; ++i) {
+        const uint8_t* frame = task.frames + i * ambe_log::kFrameBytes;
+        if (i < segment.first) {
+            mbelib_audio::decode_frame_float(*decoder, quiet, frame, discard.data());
+            warmup_skipped = quiet.skipped();
+            continue;
+        }
+        float* pcm = segment_pcm.data() + (i - segment.first) * mbelib_audio::kFrameSamples;
+        task.produced[i] = static_cast<uint8_t>(mbelib_audio::decode_frame_float(*decoder, quiet, frame, pcm));
+    }
+    task.skipped += quiet.skipped() - warmup_skipped;
+}
+
+/* AGC, int16 conversion and upsampling run once over the whole file in
+ * frame order, so gain is continuous across segment cuts. Each frame is
+ * encoded and written as it comes out, and each segment's PCM is released
+ * once written, so nothing the size of the output is ever held. */
+Result finish_task(FileTask& task, const Job& job, const OutputFormat& format) {
+    Result result{};
+    const uint32_t sample_rate = format.sample_rate;
+
+    std::FILE* out = std::fopen(job.output.c_str(), "wb");
+    if (!out) {
+        result.error = "WAV create failed";
+        return result;
+    }
+
+    // Placeholder until the sample and byte counts are known
+    std::array<uint8_t, mbelib_audio::kMaxWavHeaderSize> header{};
+    const size_t header_size = mbelib_audio::wav_header_size(format.encoding);
+    bool written = (std::fwrite(header.data(), 1, header_size, out) == header_size);
+
+    mbelib_audio::AutoGain agc{};
+    mbelib_audio::Upsampler upsampler{};
+    mbelib_audio::WavEncoder encoder{};
+    encoder.reset(format.encoding);
+    std::array<int16_t, mbelib_audio::kFrameSamples> frame_pcm{};
+    std::array<int16_t, mbelib_audio::kUpsampledFrameSamples> upsampled{};
+    std::array<uint8_t, mbelib_audio::WavEncoder::max_encoded_bytes(mbelib_audio::kUpsampledFrameSamples)> data{};
+    size_t pcm_count = 0;
+    size_t data_bytes = 0;
+
+    for (size_t s = 0; s < task.segments.size(); ++s) {
+        const Segment& segment = task.segments[s];
+        for (size_t i = segment.first; written && i < segment.last; ++i) {
+            const size_t produced = task.produced[i];
+            if (produced == 0) {
+                ++result.frame_errors;
+                continue;
+            }
+            const float* samples = task.segment_pcm[s].data() + (i - segment.first) * mbelib_audio::kFrameSamples;
+            agc.apply_to_int16(samples, produced, frame_pcm.data());
+            const int16_t* pcm = frame_pcm.data();
+            size_t count = produced;
+            if (sample_rate != mbelib_audio::kDecodeSampleRate) {
+                count = upsampler.process(frame_pcm.data(), produced, upsampled.data());
+                pcm = upsampled.data();
+            }
+            const size_t bytes = encoder.encode(pcm, count, data.data());
+            written = (std::fwrite(data.data(), 1, bytes, out) == bytes);
+            pcm_count += count;
+            data_bytes += bytes;
+        }
+        std::vector<float>().swap(task.segment_pcm[s]);
+    }
+
+    std::array<uint8_t, mbelib_audio::kImaBlockAlign> tail{};
+    const size_t tail_bytes = encoder.flush(tail.data());
+    written = written && (std::fwrite(tail.data(), 1, tail_bytes, out) == tail_bytes);
+    data_bytes += tail_bytes;
+
+    mbelib_audio::make_wav_header(format.encoding,
+                                  sample_rate,
+                                  static_cast<uint32_t>(pcm_count),
+                                  static_cast<uint32_t>(data_bytes),
+                                  header.data());
+    written = written && (std::fseek(out, 0, SEEK_SET) == 0) &&
+              (std::fwrite(header.data(), 1, header_size, out) == header_size);
+    if ((std::fclose(out) != 0) || !written) {
+        std::remove(job.output.c_str());
+        result.error = "WAV write failed";
+        return result;
+    }
+
+    result.ok = true;
+    result.frames = static_cast<uint32_t>(task.frame_count);
+    result.segments = static_cast<uint32_t>(task.segments.size());
+    result.skipped = task.skipped;
+    result.corrupt_blocks = task.corrupt_blocks;
+    result.samples = static_cast<uint32_t>(pcm_count);
+    result.seconds = static_cast<double>(pcm_count) / sample_rate;
+    return result;
+}
+
+void report_result(const Job& job, const Result& result) {
+    if (result.ok) {
+        std::printf("%s: %u frames, %u errors, %u skipped, %u segments, %.1f s",
+                    job.output.c_str(),
+                    result.frames,
+                    result.frame_errors,
+                    result.skipped,
+                    result.segments,
+                    result.seconds);
+        if (result.corrupt_blocks > 0) {
+            std::printf(", %u corrupt blocks skipped", result.corrupt_blocks);
+        }
+        std::printf("\n");
+    } else {
+        std::fprintf(stderr, "%s: %s\n", job.input.c_str(), result.error);
+    }
+}
+
+/* Hands out segments across all files. A file is opened when a worker
+ * runs out of segments, so only about one file per thread is in memory. */
+class Scheduler {
+   public:
+    Scheduler(const std::vector<Job>& jobs,
+              std::vector<Result>& results,
+              bool split,
+              int call,
+              const OutputFormat& format)
+        : jobs_{jobs},
+          results_{results},
+          split_{split},
+          call_{call},
+          format_{format},
+          tasks_(jobs.size()) {}
+
+    struct Work {
+        size_t file;
+        FileTask* task;
+        size_t segment;
+    };
+
+    bool next(Work& work) {
+        std::lock_guard<std::mutex> lock{mutex_};
+        while (pending_segment_ >= segments_of_current()) {
+            if (next_file_ >= jobs_.size()) {
+                return false;
+            }
+            const size_t file = next_file_++;
+            tasks_[file] = std::make_unique<FileTask>(jobs_[file]);
+            if (const char* error = open_task(*tasks_[file], split_, call_)) {
+                tasks_[file].reset();
+                results_[file].error = error;
+                report(file);
+                continue;
+            }
+            current_file_ = file;
+            pending_segment_ = 0;
+        }
+        work = {current_file_, tasks_[current_file_].get(), pending_segment_++};
+        return true;
+    }
+
+    /* Called after a segment is decoded; the last one finishes the file. */
+    void done(const Work& work) {
+        if (work.task->remaining.fetch_sub(1) != 1) {
+            return;
+        }
+        results_[work.file] = finish_task(*work.task, jobs_[work.file], format_);
+        std::lock_guard<std::mutex> lock{mutex_};
+        tasks_[work.file].reset();
+        report(work.file);
+    }
+
+   private:
+    size_t segments_of_current() const {
+        const auto& task = tasks_[current_file_];
+        return task ? task->segments.size() : 0;
+    }
+
+    void report(size_t file) const {
+        report_result(jobs_[file], results_[file]);
+    }
+
+    const std::vector<Job>& jobs_;
+    std::vector<Result>& results_;
+    bool split_;
+    int call_;
+    OutputFormat format_;
+    std::vector<std::unique_ptr<FileTask>> tasks_;
+    std::mutex mutex_{};
+    size_t next_file_{0};
+    size_t current_file_{0};
+    size_t pending_segment_{0};
+};
+
+/* --follow: one capture decoded as it grows. Each poll decodes the whole
+ * frames (v1) or blocks (v2) appended since the last, through the same
+ * decoder, AGC and upsampler, appends them to the WAV and rewrites its
+ * header, so the WAV plays up to the last poll at any time. A finished
+ * capture decodes to the same WAV as without --follow. */
+class Follower {
+   public:
+    Follower(const Job& job, const OutputFormat& format)
+        : job_{job},
+          format_{format},
+          decoder_{std::make_unique<mbe::MBEDecoder>()} {
+        decoder_->reset();
+        mbe_rng_seed(MBE_RNG_SEED);
+        encoder_.reset(format.encoding);
+    }
+
+    ~Follower() {
+        if (out_) {
+            std::fclose(out_);
+        }
+    }
+
+    Follower(const Follower&) = delete;
+    Follower& operator=(const Follower&) = delete;
+
+    const char* start() {
+        out_ = std::fopen(job_.output.c_str(), "wb");
+        if (!out_) {
+            return "WAV create failed";
+        }
+        return write_header() ? nullptr : "WAV write failed";
+    }
+
+    /* Decodes what has been appended. grew is set when there was any;
+     * closed once a v2 file's index has been written, after which nothing
+     * more will come. */
+    const char* poll(bool& grew, bool& closed) {
+        grew = false;
+        closed = false;
+        std::error_code ec;
+        if (!fs::exists(job_.input, ec)) {
+            // Not created, or not synced over, yet
+            return nullptr;
+        }
+        const size_t size = static_cast<size_t>(fs::file_size(job_.input, ec));
+        std::FILE* in = ec ? nullptr : std::fopen(job_.input.c_str(), "rb");
+        if (!in) {
+            return "open failed";
+        }
+        const char* error = have_header_ ? nullptr : read_header(in, size);
+        if (!error && have_header_) {
+            error = v2_ ? poll_v2(in, size, grew, closed) : poll_v1(in, size, grew);
+        }
+        std::fclose(in);
+        if (!error && grew && !write_header()) {
+            error = "WAV write failed";
+        }
+        return error;
+    }
+
+    Result finish() {
+        Result result{};
+        std::array<uint8_t, mbelib_audio::kImaBlockAlign> tail{};
+        const size_t tail_bytes = encoder_.flush(tail.data());
+        const bool written = (std::fwrite(tail.data(), 1, tail_bytes, out_) == tail_bytes);
+        data_bytes_ += tail_bytes;
+        if (!written || !write_header() || (std::fclose(out_) != 0)) {
+            out_ = nullptr;
+            result.error = "WAV write failed";
+            return result;
+        }
+        out_ = nullptr;
+
+        result.ok = true;
+        result.frames = frames_;
+        result.frame_errors = frame_errors_;
+        result.skipped = quiet_.skipped();
+        result.segments = 1;
+        result.corrupt_blocks = corrupt_blocks_;
+        result.samples = samples_;
+        result.seconds = static_cast<double>(samples_) / format_.sample_rate;
+        return result;
+    }
+
+    uint32_t frames() const { return frames_; }
+
+   private:
+    static bool read_at(std::FILE* in, size_t offset, void* data, size_t bytes) {
+        return (std::fseek(in, static_cast<long>(offset), SEEK_SET) == 0) &&
+               (std::fread(data, 1, bytes, in) == bytes);
+    }
+
+    /* The header decides v1 or v2; until it is all there, wait. */
+    const char* read_header(std::FILE* in, size_t size) {
+        ambe_log::v2::FileHeader header{};
+        const size_t bytes = std::min(size, sizeof(header));
+        if (bytes < sizeof(ambe_log::Header) || !read_at(in, 0, &header, bytes)) {
+            return nullptr;
+        }
+        if (ambe_log::v2::is_v2(&header, bytes)) {
+            if (bytes < sizeof(header)) {
+                return nullptr;
+            }
+            if (!ambe_log::v2::validate(header)) {
+                return "bad header";
+            }
+            v2_ = true;
+            offset_ = ambe_log::v2::kBlockBytes;
+        } else {
+            ambe_log::Header v1{};
+            std::memcpy(&v1, &header, sizeof(v1));
+            if (!ambe_log::validate(v1)) {
+                return "bad header";
+            }
+            offset_ = sizeof(v1);
+        }
+        have_header_ = true;
+        return nullptr;
+    }
+
+    const char* poll_v1(std::FILE* in, size_t size, bool& grew) {
+        // A trailing partial frame is still being written
+        const size_t count = (size - offset_) / ambe_log::kFrameBytes;
+        if (count == 0) {
+            return nullptr;
+        }
+        std::vector<uint8_t> data(count * ambe_log::kFrameBytes);
+        if (!read_at(in, offset_, data.data(), data.size())) {
+            return "read failed";
+        }
+        for (size_t i = 0; i < count; ++i) {
+            decode(data.data() + i * ambe_log::kFrameBytes);
+        }
+        offset_ += data.size();
+        grew = true;
+        return nullptr;
+    }
+
+    const char* poll_v2(std::FILE* in, size_t size, bool& grew, bool& closed) {
+        using namespace ambe_log::v2;
+        // Read before the blocks: once the index is in, every data block is
+        FileHeader header{};
+        if (!read_at(in, 0, &header, sizeof(header)) || !validate(header)) {
+            return "bad header";
+        }
+        const bool index_written = (header.index_block != kNoBlock);
+
+        const size_t blocks = size / kBlockBytes;
+        if (blocks <= next_block_) {
+            closed = index_written;
+            return nullptr;
+        }
+        std::vector<DataBlock> data(blocks - next_block_);
+        if (!read_at(in, next_block_ * kBlockBytes, data.data(), data.size() * kBlockBytes)) {
+            return "read failed";
+        }
+
+        for (size_t i = 0; i < data.size(); ++i) {
+            const DataBlock& block = data[i];
+            const uint32_t sequence = static_cast<uint32_t>(next_block_);
+            const BlockKind kind = classify_block(block, sequence);
+            if (kind == BlockKind::Corrupt) {
+                // The last block may be caught half copied; look again
+                // next poll
+                if (i + 1 == data.size() && !index_written) {
+                    break;
+                }
+                ++corrupt_blocks_;
+                ++next_block_;
+                if (++corrupt_run_ == kMaxCorruptRun) {
+                    closed = true;
+                    return nullptr;
+                }
+                continue;
+            }
+            ++next_block_;
+            if (kind == BlockKind::Index) {
+                continue;
+            }
+            corrupt_run_ = 0;
+            for (size_t f = 0; f < block.frame_count(); ++f) {
+                decode(block.frames[f]);
+            }
+            grew = true;
+        }
+        closed = index_written;
+        return nullptr;
+    }
+
+    void decode(const uint8_t* frame) {
+        ++frames_;
+        std::array<float, mbelib_audio::kFrameSamples> samples{};
+        const size_t produced = mbelib_audio::decode_frame_float(*decoder_, quiet_, frame, samples.data());
+        if (produced == 0) {
+            ++frame_errors_;
+            return;
+        }
+
+        std::array<int16_t, mbelib_audio::kUpsampledFrameSamples> pcm{};
+        size_t count = produced;
+        if (format_.sample_rate == mbelib_audio::kDecodeSampleRate) {
+            agc_.apply_to_int16(samples.data(), produced, pcm.data());
+        } else {
+            std::array<int16_t, mbelib_audio::kFrameSamples> frame_pcm{};
+            agc_.apply_to_int16(samples.data(), produced, frame_pcm.data());
+            count = upsampler_.process(frame_pcm.data(), produced, pcm.data());
+        }
+
+        std::array<uint8_t, mbelib_audio::WavEncoder::max_encoded_bytes(mbelib_audio::kUpsampledFrameSamples)> data{};
+        const size_t bytes = encoder_.encode(pcm.data(), count, data.data());
+        write_ok_ = write_ok_ && (std::fwrite(data.data(), 1, bytes, out_) == bytes);
+        samples_ += static_cast<uint32_t>(count);
+        data_bytes_ += static_cast<uint32_t>(bytes);
+    }
+
+    bool write_header() {
+        std::array<uint8_t, mbelib_audio::kMaxWavHeaderSize> header{};
+        const size_t header_size = mbelib_audio::make_wav_header(format_.encoding, format_.sample_rate,
+                                                                 samples_, data_bytes_, header.data());
+        return write_ok_ && (std::fseek(out_, 0, SEEK_SET) == 0) &&
+               (std::fwrite(header.data(), 1, header_size, out_) == header_size) &&
+               (std::fseek(out_, 0, SEEK_END) == 0) && (std::fflush(out_) == 0);
+    }
+
+    const Job& job_;
+    OutputFormat format_;
+    std::unique_ptr<mbe::MBEDecoder> decoder_;
+    mbelib_audio::QuietSkip quiet_{};
+    mbelib_audio::AutoGain agc_{};
+    mbelib_audio::Upsampler upsampler_{};
+    mbelib_audio::WavEncoder encoder_{};
+    std::FILE* out_{nullptr};
+    bool write_ok_{true};
+    bool have_header_{false};
+    bool v2_{false};
+    size_t offset_{0};      // v1: next frame
+    size_t next_block_{1};  // v2: next block
+    uint32_t corrupt_run_{0};
+    uint32_t corrupt_blocks_{0};
+    uint32_t frames_{0};
+    uint32_t frame_errors_{0};
+    uint32_t samples_{0};
+    uint32_t data_bytes_{0};
+};
+
+/* Polls every poll_ms until a v2 capture is closed or idle_s seconds go
+ * by without it growing. */
+int follow(const Job& job, const OutputFormat& format, unsigned poll_ms, unsigned idle_s) {
+    Follower follower{job, format};
+    if (const char* error = follower.start()) {
+        Result result{};
+        result.error = error;
+        report_result(job, result);
+        return 1;
+    }
+
+    auto last_growth = std::chrono::steady_clock::now();
+    while (true) {
+        bool grew = false;
+        bool closed = false;
+        if (const char* error = follower.poll(grew, closed)) {
+            Result result = follower.finish();
+            result.ok = false;
+            result.error = error;
+            report_result(job, result);
+            return 1;
+        }
+        const auto now = std::chrono::steady_clock::now();
+        if (grew) {
+            last_growth = now;
+            std::printf("%s: %u frames\n", job.output.c_str(), follower.frames());
+            std::fflush(stdout);
+        }
+        if (closed || (now - last_growth >= std::chrono::seconds(idle_s))) {
+            break;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(poll_ms));
+    }
+
+    const Result result = follower.finish();
+    report_result(job, result);
+    return result.ok ? 0 : 1;
+}
+
+bool is_ambe(const fs::path& path) {
+    std::string ext = path.extension().string();
+    std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) { return std::tolower(c); });
+    return ext == ".ambe";
+}
+
+fs::path output_for(const fs::path& input, const std::string& out_dir, int call) {
+    fs::path output = out_dir.empty() ? input : fs::path{out_dir} / input.filename();
+    if (call >= 0) {
+        output.replace_extension();
+        output += "_call" + std::to_string(call + 1);
+    }
+    output.replace_extension(".wav");
+    return output;
+}
+
+void usage() {
+    std::fprintf(stderr,
+                 "usage: ambe2wav [--threads N] [--out DIR] [--rate HZ] [--format F] [--split] [--call N] <file.ambe|dir>...\n"
+                 "       ambe2wav --follow [--poll MS] [--idle S] [--out DIR] [--rate HZ] [--format F] <file.ambe>\n"
+                 "  Directories are searched recursively for .ambe files.\n"
+                 "  --threads N  worker threads (default: all cores)\n"
+                 "  --out DIR    write .wav files to DIR instead of next to each input\n"
+                 "  --rate HZ    48000 (default, upsampled as on the device) or 8000 (native)\n"
+                 "  --format F   pcm (default), ulaw (G.711, 2:1) or adpcm (IMA, 4:1)\n"
+                 "  --split      decode long files in parallel segments cut at silence or\n"
+                 "               erasure runs (output is no longer bit-identical to the device)\n"
+                 "  --call N     decode only call N (from 1) of each v2 file, to NAME_callN.wav\n"
+                 "  --follow     decode a capture that is still growing, appending to the WAV\n"
+                 "               as frames arrive (pcm or ulaw); ends when a v2 file is closed\n"
+                 "  --poll MS    --follow: check for new frames every MS ms (default 1000)\n"
+                 "  --idle S     --follow: give up after S s without growth (default 60)\n");
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+    std::string out_dir{};
+    bool split = false;
+    int call = -1;
+    bool follow_input = false;
+    unsigned poll_ms = 1000;
+    unsigned idle_s = 60;
+    OutputFormat format{};
+    std::vector<Job> jobs{};
+
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--threads" && (i + 1 < argc)) {
+            threads = static_cast<unsigned>(std::max(1, std::atoi(argv[++i])));
+        } else if (arg == "--out" && (i + 1 < argc)) {
+            out_dir = argv[++i];
+        } else if (arg == "--rate" && (i + 1 < argc)) {
+            format.sample_rate = static_cast<uint32_t>(std::atoi(argv[++i]));
+            if (format.sample_rate != mbelib_audio::kPlaybackSampleRate &&
+                format.sample_rate != mbelib_audio::kDecodeSampleRate) {
+                usage();
+                return 1;
+            }
+        } else if (arg == "--format" && (i + 1 < argc)) {
+            const std::string encoding = argv[++i];
+            if (encoding == "pcm") {
+                format.encoding = mbelib_audio::WavFormat::Pcm16;
+            } else if (encoding == "ulaw") {
+                format.encoding = mbelib_audio::WavFormat::MuLaw;
+            } else if (encoding == "adpcm") {
+                format.encoding = mbelib_audio::WavFormat::ImaAdpcm;
+            } else {
+                usage();
+                return 1;
+            }
+        } else if (arg == "--split") {
+            split = true;
+        } else if (arg == "--follow") {
+            follow_input = true;
+        } else if (arg == "--poll" && (i + 1 < argc)) {
+            poll_ms = static_cast<unsigned>(std::max(1, std::atoi(argv[++i])));
+        } else if (arg == "--idle" && (i + 1 < argc)) {
+            idle_s = static_cast<unsigned>(std::max(0, std::atoi(argv[++i])));
+        } else if (arg == "--call" && (i + 1 < argc)) {
+            call = std::atoi(argv[++i]) - 1;
+            if (call < 0) {
+                usage();
+                return 1;
+            }
+        } else if (!arg.empty() && arg[0] != '-') {
+            const fs::path path{arg};
+            std::error_code ec;
+            if (fs::is_directory(path, ec)) {
+                for (const auto& entry : fs::recursive_directory_iterator(path, ec)) {
+                    if (entry.is_regular_file() && is_ambe(entry.path())) {
+                        jobs.push_back({entry.path(), {}});
+                    }
+                }
+            } else {
+                jobs.push_back({path, {}});
+            }
+        } else {
+            usage();
+            return 1;
+        }
+    }
+    if (jobs.empty()) {
+        usage();
+        return 1;
+    }
+
+    if (follow_input) {
+        // One growing file, decoded in order; ADPCM blocks cannot be left
+        // open between polls
+        if (jobs.size() != 1 || split || call >= 0 || format.encoding == mbelib_audio::WavFormat::ImaAdpcm) {
+            usage();
+            return 1;
+        }
+        jobs[0].output = output_for(jobs[0].input, out_dir, call);
+        return follow(jobs[0], format, poll_ms, idle_s);
+    }
+
+    std::sort(jobs.begin(), jobs.end(), [](const Job& a, const Job& b) { return a.input < b.input; });
+    for (auto& job : jobs) {
+        job.output = output_for(job.input, out_dir, call);
+    }
+
+    std::vector<Result> results(jobs.size());
+    Scheduler scheduler{jobs, results, split, call, format};
+
+    const auto t0 = std::chrono::steady_clock::now();
+    auto worker = [&]() {
+        Scheduler::Work work{};
+        while (scheduler.next(work)) {
+            decode_segment(*work.task, work.segment);
+            scheduler.done(work);
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for (unsigned t = 1; t < threads; ++t) {
+        pool.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : pool) {
+        thread.join();
+    }
+    const std::chrono::duration<double> wall = std::chrono::steady_clock::now() - t0;
+
+    uint32_t converted = 0;
+    double audio_seconds = 0.0;
+    for (const auto& result : results) {
+        if (result.ok) {
+            ++converted;
+            audio_seconds += result.seconds;
+        }
+    }
+    std::printf("total: %u/%zu files, %.1f s audio in %.2f s (%.0fx real time, %u threads)\n",
+                converted,
+                jobs.size(),
+                audio_seconds,
+                wall.count(),
+                (wall.count() > 0.0) ? audio_seconds / wall.count() : 0.0,
+                threads);
+    return (converted == jobs.size()) ? 0 : 1;
+}
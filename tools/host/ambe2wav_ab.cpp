@@ -0,0 +1,171 @@
+/*
+ * Copyright (C) 2025 comparchitect (https://github.com/comparchitect)
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* A/B check of the decode fast paths.
+ *
+ * Decodes the same captures with ambe2wav_ref (unpatched mbelib, every
+ * frame through the vocoder) and ambe2wav (window-gated comfort noise,
+ * erasure skip), one thread each, best of three runs. Prints both decode
+ * times and the speedup, and fails unless every WAV is byte for byte the
+ * same. Without captures it writes pseudo-random v2 ones, which are
+ * mostly voice; pass real captures for a representative speedup.
+ *
+ *   ambe2wav_ab <ambe2wav_ref> <ambe2wav> [file.ambe|dir]...
+ */
+
+#include "apps/ambe_log_v2.hpp"
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr size_t kFiles = 2;
+constexpr size_t kBurstsPerFile = 2000;  // Two minutes of audio each
+constexpr int kRuns = 3;
+
+struct FileSink {
+    std::FILE* file;
+
+    bool write(const void* data, size_t bytes) {
+        return std::fwrite(data, 1, bytes, file) == bytes;
+    }
+
+    bool rewrite_header(const ambe_log::v2::FileHeader& header) {
+        return std::fseek(file, 0, SEEK_SET) == 0 && write(&header, sizeof(header));
+    }
+};
+
+bool write_capture(const fs::path& path, uint32_t seed) {
+    std::FILE* file = std::fopen(path.c_str(), "wb");
+    if (!file) {
+        return false;
+    }
+    std::mt19937 rng{seed};
+    std::uniform_int_distribution<int> byte{0, 255};
+    uint8_t frames[ambe_log::v2::kFramesPerBurst * ambe_log::kFrameBytes];
+
+    FileSink sink{file};
+    ambe_log::v2::Writer writer{};
+    bool ok = writer.begin(sink, 0);
+    for (size_t b = 0; ok && b < kBurstsPerFile; ++b) {
+        for (auto& value : frames) {
+            value = static_cast<uint8_t>(byte(rng));
+        }
+        const ambe_log::v2::Writer::Burst burst{
+            b * ambe_log::v2::kFramesPerBurst * ambe_log::v2::kFrameSamples, 0, 0, 0, 0, frames};
+        ok = writer.add_burst(sink, burst);
+    }
+    ok = ok && writer.finish(sink);
+    return (std::fclose(file) == 0) && ok;
+}
+
+std::vector<char> read_all(const fs::path& path) {
+    std::ifstream in{path, std::ios::binary};
+    return {std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+}
+
+/* Best wall time of kRuns decodes of inputs into out, or a negative
+ * value if ambe2wav failed. */
+double decode(const std::string& ambe2wav, const std::string& inputs, const fs::path& out) {
+    fs::create_directories(out);
+    const std::string command = "\"" + ambe2wav + "\" --threads 1 --out \"" + out.string() + "\"" + inputs +
+                                " > /dev/null";
+    double best = -1.0;
+    for (int run = 0; run < kRuns; ++run) {
+        const auto t0 = std::chrono::steady_clock::now();
+        if (std::system(command.c_str()) != 0) {
+            return -1.0;
+        }
+        const std::chrono::duration<double> wall = std::chrono::steady_clock::now() - t0;
+        best = (best < 0.0) ? wall.count() : std::min(best, wall.count());
+    }
+    return best;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        std::fprintf(stderr, "usage: ambe2wav_ab <ambe2wav_ref> <ambe2wav> [file.ambe|dir]...\n");
+        return 2;
+    }
+
+    const fs::path root = fs::temp_directory_path() / ("ambe2wav_ab." + std::to_string(::getpid()));
+    std::string inputs{};
+    if (argc > 3) {
+        for (int i = 3; i < argc; ++i) {
+            inputs += " \"" + std::string{argv[i]} + "\"";
+        }
+    } else {
+        const fs::path in = root / "in";
+        fs::create_directories(in);
+        for (size_t i = 0; i < kFiles; ++i) {
+            if (!write_capture(in / ("capture" + std::to_string(i) + ".ambe"), static_cast<uint32_t>(i + 1))) {
+                std::fprintf(stderr, "cannot write captures in %s\n", in.c_str());
+                return 2;
+            }
+        }
+        inputs = " \"" + in.string() + "\"";
+    }
+
+    const double ref_seconds = decode(argv[1], inputs, root / "ref");
+    const double fast_seconds = (ref_seconds >= 0.0) ? decode(argv[2], inputs, root / "fast") : -1.0;
+
+    size_t wavs = 0;
+    size_t differ = 0;
+    std::error_code ec;
+    if (fast_seconds >= 0.0) {
+        for (const auto& entry : fs::directory_iterator(root / "ref", ec)) {
+            const fs::path fast = root / "fast" / entry.path().filename();
+            ++wavs;
+            if (read_all(entry.path()) != read_all(fast)) {
+                std::fprintf(stderr, "%s differs from the reference decode\n", entry.path().filename().c_str());
+                ++differ;
+            }
+        }
+    }
+
+    fs::remove_all(root, ec);
+    if (fast_seconds < 0.0) {
+        std::fprintf(stderr, "ambe2wav failed\n");
+        return 1;
+    }
+    std::printf("%zu WAVs %s; reference %.2f s, fast %.2f s (%.2fx)\n",
+                wavs,
+                (differ == 0 && wavs != 0) ? "identical" : "DIFFERENT",
+                ref_seconds,
+                fast_seconds,
+                (fast_seconds > 0.0) ? ref_seconds / fast_seconds : 0.0);
+    return (differ == 0 && wavs != 0) ? 0 : 1;
+}
@@ -0,0 +1,155 @@
+/*
+ * Copyright (C) 2025 comparchitect (https://github.com/comparchitect)
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __AMBE_FILE_WRITER_H__
+#define __AMBE_FILE_WRITER_H__
+
+#include "apps/ambe_log_format.hpp"
+#include "apps/ambe_log_v2.hpp"
+#include "apps/ambe_processing.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <ctime>
+#include <string>
+
+namespace host {
+
+/* Writes DMR voice bursts to a .ambe file exactly as DSDView does on the
+ * device: a v2 header, then one packed frame per AMBE frame after
+ * deinterleave and sanitize, in blocks with the call index written on
+ * close. The RTC fields count from when the file was opened. */
+class AmbeFileWriter {
+   public:
+    static constexpr size_t kFramesPerBurst = ambe_log::v2::kFramesPerBurst;
+
+    AmbeFileWriter() = default;
+    ~AmbeFileWriter() { close(); }
+
+    AmbeFileWriter(const AmbeFileWriter&) = delete;
+    AmbeFileWriter& operator=(const AmbeFileWriter&) = delete;
+
+    bool open(const std::string& path) {
+        close();
+        file_ = std::fopen(path.c_str(), "wb");
+        if (!file_) {
+            return false;
+        }
+        opened_ = std::time(nullptr);
+        Sink sink{file_};
+        return writer_.begin(sink, rtc_at(0));
+    }
+
+    /* Finishes the file (last call, trailing index); false if that failed. */
+    bool close() {
+        if (!file_) {
+            return true;
+        }
+        Sink sink{file_};
+        const bool ok = writer_.finish(sink);
+        std::fclose(file_);
+        file_ = nullptr;
+        return ok;
+    }
+
+    bool is_open() const { return file_ != nullptr; }
+
+    /* start_sample is the burst's 48 kHz timestamp from DMRSymbolCore. */
+    bool write_burst(const uint8_t* burst_bytes, uint64_t start_sample, uint8_t channel = 0, uint8_t sync = 0, uint8_t slot = 0) {
+        if (!file_ || !burst_bytes) {
+            return false;
+        }
+
+        char ambe_frames[kFramesPerBurst][4][24];
+        ambe_processing::deinterleave_ambe_burst(burst_bytes, ambe_frames);
+
+        std::array<uint8_t, kFramesPerBurst * ambe_log::kFrameBytes> packed_burst{};
+        for (size_t frame = 0; frame < kFramesPerBurst; ++frame) {
+            char ambe_d[49]{};
+            int errs2 = 0;
+            ambe_processing::sanitize_frame(ambe_frames[frame], ambe_d, &errs2);
+            const auto packed = ambe_processing::pack_frame(ambe_frames[frame], static_cast<uint8_t>(errs2));
+            std::copy(packed.begin(), packed.end(), packed_burst.begin() + frame * ambe_log::kFrameBytes);
+        }
+
+        const ambe_log::v2::Writer::Burst burst{
+            start_sample,
+            rtc_at(start_sample / ambe_log::v2::kTimestampRate),
+            channel,
+            sync,
+            slot,
+            packed_burst.data()};
+        Sink sink{file_};
+        if (!writer_.add_burst(sink, burst)) {
+            return false;
+        }
+        frames_written_ += kFramesPerBurst;
+        return true;
+    }
+
+    /* Ends the call open on channel, as DSDView does on a DSDCallEvent. */
+    bool end_call(uint8_t channel) {
+        if (!file_) {
+            return true;
+        }
+        Sink sink{file_};
+        return writer_.close_call(sink, channel);
+    }
+
+    uint32_t frames_written() const { return frames_written_; }
+    uint32_t calls() const { return writer_.calls(); }
+
+   private:
+    struct Sink {
+        std::FILE* file;
+
+        bool write(const void* data, size_t bytes) {
+            return std::fwrite(data, 1, bytes, file) == bytes;
+        }
+
+        bool rewrite_header(const ambe_log::v2::FileHeader& header) {
+            return std::fseek(file, 0, SEEK_SET) == 0 && write(&header, sizeof(header));
+        }
+    };
+
+    uint32_t rtc_at(uint64_t seconds) const {
+        const std::time_t when = opened_ + static_cast<std::time_t>(seconds);
+        std::tm local{};
+        localtime_r(&when, &local);
+        return ambe_log::v2::pack_time(static_cast<uint16_t>(local.tm_year + 1900),
+                                       static_cast<uint8_t>(local.tm_mon + 1),
+                                       static_cast<uint8_t>(local.tm_mday),
+                                       static_cast<uint8_t>(local.tm_hour),
+                                       static_cast<uint8_t>(local.tm_min),
+                                       static_cast<uint8_t>(local.tm_sec));
+    }
+
+    std::FILE* file_{nullptr};
+    ambe_log::v2::Writer writer_{};
+    std::time_t opened_{0};
+    uint32_t frames_written_{0};
+};
+
+}  // namespace host
+
+#endif /*__AMBE_FILE_WRITER_H__*/
@@ -0,0 +1,341 @@
+/*
+ * Copyright (C) 2025 comparchitect (https://github.com/comparchitect)
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Checks how ambe2wav reads damaged .ambe v2 files.
+ *
+ * Writes a v2 capture of many calls (so the index spans several pages),
+ * damages copies of it, and decodes each with ambe2wav. For every copy the
+ * reported corrupt block count must match the blocks damaged, and the WAV
+ * must equal the decode of a clean file holding only the frames of the
+ * surviving data blocks:
+ *
+ *   data     bad CRC, bad magic and bad sequence number in data blocks,
+ *            including the first and last block of a call
+ *   index    a mid-file index page with a bad magic (a corrupt block) and
+ *            a trailing page with a bad entry count (still an index page,
+ *            but not followed); --call must still find calls by scanning
+ *   run      kMaxCorruptRun bad blocks in a row end the data
+ *
+ *   ambe_log_check <path to ambe2wav>
+ */
+
+#include "apps/ambe_log_v2.hpp"
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+using namespace ambe_log::v2;
+
+namespace {
+
+constexpr uint32_t kCalls = 40;  // More than one index page of entries
+
+struct FileSink {
+    std::FILE* file;
+
+    bool write(const void* data, size_t bytes) {
+        return std::fwrite(data, 1, bytes, file) == bytes;
+    }
+
+    bool rewrite_header(const FileHeader& header) {
+        return std::fseek(file, 0, SEEK_SET) == 0 && write(&header, sizeof(header));
+    }
+};
+
+using Bytes = std::vector<uint8_t>;
+
+Bytes read_all(const fs::path& path) {
+    std::ifstream in{path, std::ios::binary};
+    return {std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+}
+
+bool write_all(const fs::path& path, const Bytes& data) {
+    std::ofstream out{path, std::ios::binary};
+    out.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+    return static_cast<bool>(out);
+}
+
+/* Calls of 4 to 40 bursts, a two-second gap between them. */
+bool write_capture(const fs::path& path) {
+    std::FILE* file = std::fopen(path.c_str(), "wb");
+    if (!file) {
+        return false;
+    }
+    std::mt19937 rng{11};
+    std::uniform_int_distribution<int> byte{0, 255};
+    std::uniform_int_distribution<int> length{4, 40};
+    uint8_t frames[kFramesPerBurst * ambe_log::kFrameBytes];
+
+    FileSink sink{file};
+    Writer writer{};
+    bool ok = writer.begin(sink, pack_time(2025, 1, 1, 12, 0, 0));
+    uint64_t sample = 0;
+    for (uint32_t call = 0; ok && call < kCalls; ++call) {
+        const int bursts = length(rng);
+        for (int b = 0; ok && b < bursts; ++b) {
+            for (auto& value : frames) {
+                value = static_cast<uint8_t>(byte(rng));
+            }
+            ok = writer.add_burst(sink, {sample, 0, 0, 0, 0, frames});
+            sample += kFramesPerBurst * kFrameSamples;
+        }
+        sample += 2 * kTimestampRate;
+    }
+    ok = ok && writer.finish(sink);
+    return (std::fclose(file) == 0) && ok;
+}
+
+/* A clean v2 file of the given frames, in bursts as one call. */
+bool write_frames(const fs::path& path, const Bytes& frames) {
+    std::FILE* file = std::fopen(path.c_str(), "wb");
+    if (!file) {
+        return false;
+    }
+    constexpr size_t kBurstBytes = kFramesPerBurst * ambe_log::kFrameBytes;
+    FileSink sink{file};
+    Writer writer{};
+    bool ok = writer.begin(sink, 0);
+    for (size_t offset = 0; ok && offset + kBurstBytes <= frames.size(); offset += kBurstBytes) {
+        ok = writer.add_burst(sink, {(offset / kBurstBytes) * kFramesPerBurst * kFrameSamples, 0, 0, 0, 0,
+                                     frames.data() + offset});
+    }
+    ok = ok && writer.finish(sink);
+    return (std::fclose(file) == 0) && ok;
+}
+
+struct Layout {
+    std::vector<uint32_t> data_blocks;
+    std::vector<uint32_t> index_pages;
+};
+
+Layout read_layout(const Bytes& file) {
+    Layout layout{};
+    for (uint32_t b = 1; b < file.size() / kBlockBytes; ++b) {
+        DataBlock block{};
+        std::memcpy(&block, file.data() + b * kBlockBytes, sizeof(block));
+        const BlockKind kind = classify_block(block, b);
+        if (kind == BlockKind::Data) {
+            layout.data_blocks.push_back(b);
+        } else if (kind == BlockKind::Index) {
+            layout.index_pages.push_back(b);
+        }
+    }
+    return layout;
+}
+
+DataBlock& block_at(Bytes& file, uint32_t b) {
+    return *reinterpret_cast<DataBlock*>(file.data() + b * kBlockBytes);
+}
+
+/* Frames of the data blocks in [1, end) of the clean file that are not
+ * in damaged, optionally of one call only. */
+Bytes surviving_frames(const Bytes& clean,
+                       const Layout& layout,
+                       const std::vector<uint32_t>& damaged,
+                       uint32_t end,
+                       int call = -1) {
+    Bytes frames;
+    for (const uint32_t b : layout.data_blocks) {
+        if (b >= end || std::find(damaged.begin(), damaged.end(), b) != damaged.end()) {
+            continue;
+        }
+        DataBlock block{};
+        std::memcpy(&block, clean.data() + b * kBlockBytes, sizeof(block));
+        if (call >= 0 && block.header.call_id != static_cast<uint32_t>(call)) {
+            continue;
+        }
+        const uint8_t* first = &block.frames[0][0];
+        frames.insert(frames.end(), first, first + block.frame_count() * ambe_log::kFrameBytes);
+    }
+    return frames;
+}
+
+struct Report {
+    bool ok;
+    unsigned frames;
+    unsigned corrupt;
+};
+
+Report decode(const std::string& ambe2wav, const fs::path& in, const fs::path& out, int call = -1) {
+    fs::create_directories(out);
+    const std::string command = "\"" + ambe2wav + "\" --threads 1" +
+                                ((call >= 0) ? " --call " + std::to_string(call + 1) : std::string{}) +
+                                " --out \"" + out.string() + "\" \"" + in.string() + "\" 2>/dev/null";
+    Report report{false, 0, 0};
+    std::FILE* pipe = ::popen(command.c_str(), "r");
+    if (!pipe) {
+        return report;
+    }
+    char line[1024];
+    while (std::fgets(line, sizeof(line), pipe)) {
+        const char* result = std::strstr(line, ".wav: ");
+        if (result && std::sscanf(result + 6, "%u frames, %*u errors, %*u skipped, %*u segments, %*f s, %u corrupt",
+                                  &report.frames, &report.corrupt) >= 1) {
+            report.ok = true;
+        }
+    }
+    report.ok = (::pclose(pipe) == 0) && report.ok;
+    return report;
+}
+
+class Checker {
+   public:
+    Checker(std::string ambe2wav, fs::path root)
+        : ambe2wav_{std::move(ambe2wav)},
+          root_{std::move(root)} {}
+
+    /* Decodes damaged (call >= 0: one call of it) and checks the counts
+     * and that the WAV matches a clean decode of expected_frames. */
+    void check(const char* label, const Bytes& damaged, const Bytes& expected_frames, unsigned corrupt, int call = -1) {
+        const fs::path dir = root_ / (std::string{label} + ((call >= 0) ? "_call" + std::to_string(call + 1) : ""));
+        const fs::path input = dir / "capture.ambe";
+        const fs::path expected = dir / "expected.ambe";
+        fs::create_directories(dir);
+        if (!write_all(input, damaged) || !write_frames(expected, expected_frames)) {
+            fail(label, "cannot write inputs");
+            return;
+        }
+
+        const Report report = decode(ambe2wav_, input, dir / "out", call);
+        const Report reference = decode(ambe2wav_, expected, dir / "ref");
+        const unsigned frames = static_cast<unsigned>(expected_frames.size() / ambe_log::kFrameBytes);
+        const std::string wav = (call >= 0) ? "capture_call" + std::to_string(call + 1) + ".wav" : "capture.wav";
+        if (!report.ok || !reference.ok) {
+            fail(label, "ambe2wav failed");
+        } else if (report.frames != frames || report.corrupt != corrupt) {
+            std::fprintf(stderr, "%s: %u frames, %u corrupt; expected %u and %u\n", label, report.frames,
+                         report.corrupt, frames, corrupt);
+            ++failures_;
+        } else if (read_all(dir / "out" / wav) != read_all(dir / "ref" / "expected.wav")) {
+            fail(label, "WAV differs from the surviving frames");
+        } else {
+            std::printf("%-12s %5u frames, %2u corrupt blocks: ok\n", label, frames, corrupt);
+        }
+    }
+
+    unsigned failures() const { return failures_; }
+
+   private:
+    void fail(const char* label, const char* what) {
+        std::fprintf(stderr, "%s: %s\n", label, what);
+        ++failures_;
+    }
+
+    std::string ambe2wav_;
+    fs::path root_;
+    unsigned failures_{0};
+};
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::fprintf(stderr, "usage: ambe_log_check <path to ambe2wav>\n");
+        return 2;
+    }
+    const fs::path root = fs::temp_directory_path() / ("ambe_log_check." + std::to_string(::getpid()));
+    fs::create_directories(root);
+    const fs::path capture = root / "capture.ambe";
+    if (!write_capture(capture)) {
+        std::fprintf(stderr, "cannot write %s\n", capture.c_str());
+        return 2;
+    }
+    const Bytes clean = read_all(capture);
+    const Layout layout = read_layout(clean);
+    const uint32_t blocks = static_cast<uint32_t>(clean.size() / kBlockBytes);
+    if (layout.index_pages.size() < 2 || layout.data_blocks.size() < kMaxCorruptRun + 10) {
+        std::fprintf(stderr, "capture too small: %zu index pages, %zu data blocks\n", layout.index_pages.size(),
+                     layout.data_blocks.size());
+        return 2;
+    }
+
+    Checker checker{argv[1], root};
+    checker.check("clean", clean, surviving_frames(clean, layout, {}, blocks), 0);
+
+    // Data blocks: a frame byte (CRC) in the first block of the longest
+    // call, the magic in its last block, a sequence number inside the
+    // file and a burst offset in the last data block
+    {
+        std::vector<std::vector<uint32_t>> call_blocks(kCalls);
+        for (const uint32_t b : layout.data_blocks) {
+            DataBlock block{};
+            std::memcpy(&block, clean.data() + b * kBlockBytes, sizeof(block));
+            call_blocks[block.header.call_id].push_back(b);
+        }
+        const auto longest = std::max_element(call_blocks.begin(), call_blocks.end(),
+                                              [](const auto& a, const auto& b) { return a.size() < b.size(); });
+        const int call = static_cast<int>(longest - call_blocks.begin());
+
+        Bytes damaged = clean;
+        const std::vector<uint32_t> hit{longest->front(), longest->back(), layout.data_blocks[2],
+                                        layout.data_blocks.back()};
+        block_at(damaged, hit[0]).frames[4][2] ^= 0x10;
+        block_at(damaged, hit[1]).header.magic ^= 0x0100;
+        block_at(damaged, hit[2]).header.sequence += 1;
+        block_at(damaged, hit[3]).burst_offset[0] ^= 1;
+        checker.check("data", damaged, surviving_frames(clean, layout, hit, blocks), 4);
+
+        // The call decodes from its second block to the one before its last
+        checker.check("data", damaged, surviving_frames(clean, layout, hit, blocks, call), 2, call);
+    }
+
+    // Index pages: the mid-file page loses its magic and is skipped as a
+    // corrupt block; the trailing page keeps its magic but an impossible
+    // entry count, so it is passed over without being followed
+    {
+        Bytes damaged = clean;
+        const uint32_t middle = layout.index_pages.front();
+        const uint32_t trailing = layout.index_pages.back();
+        block_at(damaged, middle).header.magic = 0;
+        reinterpret_cast<IndexPage*>(damaged.data() + trailing * kBlockBytes)->header.entry_count = 0xFFFF;
+        checker.check("index", damaged, surviving_frames(clean, layout, {}, blocks), 1);
+        checker.check("index", damaged, surviving_frames(clean, layout, {}, blocks, 0), 0, 0);
+        checker.check("index", damaged, surviving_frames(clean, layout, {}, blocks, kCalls - 1), 0, kCalls - 1);
+    }
+
+    // kMaxCorruptRun bad blocks in a row are taken as the end of the data
+    {
+        Bytes damaged = clean;
+        const uint32_t start = layout.data_blocks[5];
+        std::vector<uint32_t> hit;
+        for (uint32_t b = start; b < start + kMaxCorruptRun; ++b) {
+            block_at(damaged, b).header.sequence = kNoBlock;
+            hit.push_back(b);
+        }
+        checker.check("run", damaged, surviving_frames(clean, layout, hit, start), kMaxCorruptRun);
+    }
+
+    std::error_code ec;
+    fs::remove_all(root, ec);
+    std::printf("%s\n", (checker.failures() == 0) ? "all checks passed" : "FAILED");
+    return (checker.failures() == 0) ? 0 : 1;
+}
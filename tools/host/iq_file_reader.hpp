@@ -0,0 +1,156 @@
+/*
+ * Copyright (C) 2025 comparchitect (https://github.com/comparchitect)
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __IQ_FILE_READER_H__
+#define __IQ_FILE_READER_H__
+
+#include <algorithm>
+#include <cctype>
+#include <complex>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace host {
+
+/* Reader for PortaPack IQ captures: .C8 (interleaved int8) and .C16
+ * (interleaved little-endian int16). The sample rate comes from the
+ * capture's .TXT sidecar (sample_rate=...) when one exists. */
+class IqFileReader {
+   public:
+    enum class Format {
+        C8,
+        C16
+    };
+
+    IqFileReader() = default;
+    ~IqFileReader() { close(); }
+
+    IqFileReader(const IqFileReader&) = delete;
+    IqFileReader& operator=(const IqFileReader&) = delete;
+
+    bool open(const std::string& path) {
+        close();
+        std::string ext = path.substr(path.find_last_of('.') + 1);
+        std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) { return std::toupper(c); });
+        if (ext == "C8") {
+            format_ = Format::C8;
+        } else if (ext == "C16") {
+            format_ = Format::C16;
+        } else {
+            return false;
+        }
+
+        file_ = std::fopen(path.c_str(), "rb");
+        if (!file_) {
+            return false;
+        }
+        std::fseek(file_, 0, SEEK_END);
+        total_samples_ = static_cast<uint64_t>(std::ftell(file_)) / bytes_per_sample();
+        std::fseek(file_, 0, SEEK_SET);
+
+        sample_rate_ = read_sidecar_rate(path.substr(0, path.find_last_of('.')) + ".TXT");
+        return true;
+    }
+
+    void close() {
+        if (file_) {
+            std::fclose(file_);
+            file_ = nullptr;
+        }
+    }
+
+    Format format() const { return format_; }
+    uint32_t sample_rate() const { return sample_rate_; }
+    uint64_t total_samples() const { return total_samples_; }
+    size_t bytes_per_sample() const { return (format_ == Format::C8) ? 2 : 4; }
+
+    /* Reads up to `max_samples` and returns them as full-scale floats (+-1.0). */
+    size_t read(std::complex<float>* out, size_t max_samples) {
+        raw_.resize(max_samples * bytes_per_sample());
+        const size_t got = std::fread(raw_.data(), bytes_per_sample(), max_samples, file_);
+        if (format_ == Format::C8) {
+            const auto* p = reinterpret_cast<const int8_t*>(raw_.data());
+            for (size_t i = 0; i < got; ++i) {
+                out[i] = {p[2 * i] / 128.0f, p[2 * i + 1] / 128.0f};
+            }
+        } else {
+            for (size_t i = 0; i < got; ++i) {
+                out[i] = {read_i16(4 * i) / 32768.0f, read_i16(4 * i + 2) / 32768.0f};
+            }
+        }
+        return got;
+    }
+
+    /* Reads up to `max_samples` as the baseband sees them: interleaved int8
+     * I/Q. C16 captures are reduced to their high byte. */
+    size_t read_c8(int8_t* out, size_t max_samples) {
+        raw_.resize(max_samples * bytes_per_sample());
+        const size_t got = std::fread(raw_.data(), bytes_per_sample(), max_samples, file_);
+        if (format_ == Format::C8) {
+            std::memcpy(out, raw_.data(), got * 2);
+        } else {
+            for (size_t i = 0; i < got * 2; ++i) {
+                out[i] = static_cast<int8_t>(read_i16(2 * i) >> 8);
+            }
+        }
+        return got;
+    }
+
+   private:
+    int16_t read_i16(size_t offset) const {
+        return static_cast<int16_t>(raw_[offset] | (raw_[offset + 1] << 8));
+    }
+
+    static uint32_t read_sidecar_rate(const std::string& path) {
+        std::FILE* f = std::fopen(path.c_str(), "r");
+        if (!f) {
+            std::string lower = path;
+            lower.replace(lower.size() - 3, 3, "txt");
+            f = std::fopen(lower.c_str(), "r");
+            if (!f) {
+                return 0;
+            }
+        }
+        uint32_t rate = 0;
+        char line[128];
+        while (std::fgets(line, sizeof(line), f)) {
+            if (std::strncmp(line, "sample_rate=", 12) == 0) {
+                rate = static_cast<uint32_t>(std::strtoul(line + 12, nullptr, 10));
+            }
+        }
+        std::fclose(f);
+        return rate;
+    }
+
+    std::FILE* file_{nullptr};
+    Format format_{Format::C8};
+    uint32_t sample_rate_{0};
+    uint64_t total_samples_{0};
+    std::vector<uint8_t> raw_{};
+};
+
+}  // namespace host
+
+#endif /*__IQ_FILE_READER_H__*/
@@ -0,0 +1,161 @@
+/*
+ * Copyright (C) 2025 comparchitect (https://github.com/comparchitect)
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "polyphase_channelizer.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace host {
+
+namespace {
+constexpr double kPi = 3.14159265358979323846;
+}  // namespace
+
+std::vector<float> design_lowpass(size_t length, double cutoff) {
+    std::vector<float> taps(length);
+    const double centre = (static_cast<double>(length) - 1.0) / 2.0;
+    double sum = 0.0;
+    for (size_t i = 0; i < length; ++i) {
+        const double t = static_cast<double>(i) - centre;
+        const double sinc = (t == 0.0) ? 2.0 * cutoff : std::sin(2.0 * kPi * cutoff * t) / (kPi * t);
+        const double w = 0.42 - 0.5 * std::cos(2.0 * kPi * i / (length - 1)) +
+                         0.08 * std::cos(4.0 * kPi * i / (length - 1));
+        taps[i] = static_cast<float>(sinc * w);
+        sum += taps[i];
+    }
+    for (auto& tap : taps) {
+        tap = static_cast<float>(tap / sum);
+    }
+    return taps;
+}
+
+PolyphaseChannelizer::PolyphaseChannelizer(size_t channels, size_t taps_per_branch)
+    : m_{channels},
+      p_{taps_per_branch} {
+    while ((static_cast<size_t>(1) << log2_m_) < m_) {
+        ++log2_m_;
+    }
+
+    // Cutoff at half the channel spacing; the transition band folds into
+    // the channel edges, which DMR (about 9 kHz occupied in 12.5 kHz) leaves empty.
+    prototype_ = design_lowpass(m_ * p_, 0.5 / static_cast<double>(m_));
+
+    twiddles_.resize(m_ / 2);
+    for (size_t i = 0; i < m_ / 2; ++i) {
+        const double angle = 2.0 * kPi * static_cast<double>(i) / static_cast<double>(m_);
+        twiddles_[i] = cfloat{static_cast<float>(std::cos(angle)), static_cast<float>(std::sin(angle))};
+    }
+
+    bit_reverse_.resize(m_);
+    for (size_t i = 0; i < m_; ++i) {
+        uint32_t r = 0;
+        for (size_t b = 0; b < log2_m_; ++b) {
+            r |= ((i >> b) & 1u) << (log2_m_ - 1 - b);
+        }
+        bit_reverse_[i] = r;
+    }
+}
+
+void PolyphaseChannelizer::inverse_fft(cfloat* data) const {
+    for (size_t i = 0; i < m_; ++i) {
+        const size_t j = bit_reverse_[i];
+        if (j > i) {
+            std::swap(data[i], data[j]);
+        }
+    }
+
+    for (size_t span = 2; span <= m_; span <<= 1) {
+        const size_t half = span / 2;
+        const size_t step = m_ / span;
+        for (size_t start = 0; start < m_; start += span) {
+            for (size_t i = 0; i < half; ++i) {
+                const cfloat t = twiddles_[i * step] * data[start + i + half];
+                data[start + i + half] = data[start + i] - t;
+                data[start + i] += t;
+            }
+        }
+    }
+}
+
+void PolyphaseChannelizer::compute_steps(const cfloat* input,
+                                         size_t first,
+                                         size_t last,
+                                         cfloat* out,
+                                         size_t stride,
+                                         std::vector<cfloat>& scratch) const {
+    scratch.resize(m_);
+
+    for (size_t n = first; n < last; ++n) {
+        // Newest sample of this step; the prototype runs backwards from it.
+        const cfloat* newest = input + history() + n * m_ + (m_ - 1);
+
+        for (size_t m = 0; m < m_; ++m) {
+            cfloat acc{0.0f, 0.0f};
+            for (size_t p = 0; p < p_; ++p) {
+                const size_t l = m + p * m_;
+                acc += prototype_[l] * *(newest - l);
+            }
+            scratch[m] = acc;
+        }
+
+        // y_k = sum_m u[m] * exp(+j*2*pi*k*m/M)
+        inverse_fft(scratch.data());
+
+        for (size_t k = 0; k < m_; ++k) {
+            out[k * stride + n] = scratch[k];
+        }
+    }
+}
+
+RationalResampler::RationalResampler(uint32_t interpolation, uint32_t decimation, size_t taps_per_phase)
+    : l_{interpolation},
+      d_{decimation},
+      q_{taps_per_phase},
+      history_(taps_per_phase, 0.0f) {
+    // Cutoff at the lower of the two Nyquist rates, at the interpolated rate.
+    const double cutoff = 0.5 / static_cast<double>(std::max(l_, d_));
+    prototype_ = design_lowpass(static_cast<size_t>(l_) * q_, cutoff);
+    for (auto& tap : prototype_) {
+        tap *= static_cast<float>(l_);
+    }
+}
+
+void RationalResampler::process(const float* in, size_t count, std::vector<float>& out) {
+    for (size_t i = 0; i < count; ++i) {
+        std::rotate(history_.rbegin(), history_.rbegin() + 1, history_.rend());
+        history_[0] = in[i];
+        const uint64_t n = input_index_++;
+
+        // Emit every output whose interpolated position falls on this input.
+        while ((next_output_ * d_) / l_ <= n) {
+            const uint32_t phase = static_cast<uint32_t>((next_output_ * d_) % l_);
+            float acc = 0.0f;
+            for (size_t q = 0; q < q_; ++q) {
+                acc += prototype_[phase + q * l_] * history_[q];
+            }
+            out.push_back(acc);
+            ++next_output_;
+        }
+    }
+}
+
+}  // namespace host
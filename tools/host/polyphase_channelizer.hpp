@@ -0,0 +1,99 @@
+/*
+ * Copyright (C) 2025 comparchitect (https://github.com/comparchitect)
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __POLYPHASE_CHANNELIZER_H__
+#define __POLYPHASE_CHANNELIZER_H__
+
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace host {
+
+using cfloat = std::complex<float>;
+
+/* Critically sampled polyphase FFT channelizer.
+ * Splits a complex input at fs into M channels spaced fs/M apart, each
+ * output at fs/M. Channel k (0..M-1) is centred at k*fs/M; bins above M/2
+ * are the negative offsets. M must be a power of two.
+ *
+ * Every output step only reads the input window that precedes it, so a
+ * block can be split across threads with compute_steps(). */
+class PolyphaseChannelizer {
+   public:
+    PolyphaseChannelizer(size_t channels, size_t taps_per_branch);
+
+    size_t channels() const { return m_; }
+    size_t taps_per_branch() const { return p_; }
+
+    /* Number of input samples of history each step needs before its own M. */
+    size_t history() const { return (p_ - 1) * m_; }
+
+    /* Computes output steps [first, last) of a block.
+     * `input` points at history() samples of past input followed by the
+     * block; step n consumes input[history() + n*M .. +M).
+     * Output for step n, channel k lands in out[k * stride + n]. */
+    void compute_steps(const cfloat* input,
+                       size_t first,
+                       size_t last,
+                       cfloat* out,
+                       size_t stride,
+                       std::vector<cfloat>& scratch) const;
+
+   private:
+    void inverse_fft(cfloat* data) const;
+
+    size_t m_;
+    size_t p_;
+    size_t log2_m_{0};
+    std::vector<float> prototype_{};
+    std::vector<cfloat> twiddles_{};
+    std::vector<uint32_t> bit_reverse_{};
+};
+
+/* Streaming rational resampler for real samples (polyphase FIR, up by L,
+ * down by D). Used to bring channelizer outputs to the 48 kHz the DMR
+ * symbol core expects. */
+class RationalResampler {
+   public:
+    RationalResampler(uint32_t interpolation, uint32_t decimation, size_t taps_per_phase);
+
+    /* Appends resampled output for `count` input samples to `out`. */
+    void process(const float* in, size_t count, std::vector<float>& out);
+
+   private:
+    uint32_t l_;
+    uint32_t d_;
+    size_t q_;
+    std::vector<float> prototype_{};
+    std::vector<float> history_{};
+    uint64_t input_index_{0};
+    uint64_t next_output_{0};
+};
+
+/* Windowed-sinc low-pass, cutoff normalised to the sample rate (0..0.5),
+ * Blackman window, unity DC gain. */
+std::vector<float> design_lowpass(size_t length, double cutoff);
+
+}  // namespace host
+
+#endif /*__POLYPHASE_CHANNELIZER_H__*/
@@ -0,0 +1,130 @@
+/*
+ * Copyright (C) 2025 comparchitect (https://github.com/comparchitect)
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Host stand-in for ChibiOS <hal.h> as used by the baseband DSP sources:
+ * portable C versions of the Cortex-M4 SIMD/saturation intrinsics, so
+ * dsp_decimate.cpp and dsp_demodulate.cpp compile and give bit-identical
+ * results on Linux. Only what the DSD RX chain needs is provided. */
+
+#ifndef __HOST_HAL_STUB_H__
+#define __HOST_HAL_STUB_H__
+
+#include <cstdint>
+
+namespace host_intrinsics {
+
+inline int32_t lo16(uint32_t x) { return static_cast<int16_t>(x & 0xffff); }
+inline int32_t hi16(uint32_t x) { return static_cast<int16_t>(x >> 16); }
+inline uint32_t pack16(int32_t lo, int32_t hi) {
+    return (static_cast<uint32_t>(lo) & 0xffff) | (static_cast<uint32_t>(hi) << 16);
+}
+inline int32_t sat(int64_t x, unsigned bits) {
+    const int64_t max = (int64_t{1} << (bits - 1)) - 1;
+    const int64_t min = -(int64_t{1} << (bits - 1));
+    return static_cast<int32_t>((x > max) ? max : (x < min) ? min : x);
+}
+
+}  // namespace host_intrinsics
+
+inline uint32_t __ROR(uint32_t x, uint32_t n) {
+    n &= 31;
+    return n ? ((x >> n) | (x << (32 - n))) : x;
+}
+
+inline uint32_t __SXTB16(uint32_t x) {
+    return host_intrinsics::pack16(static_cast<int8_t>(x & 0xff), static_cast<int8_t>((x >> 16) & 0xff));
+}
+
+inline uint32_t __SXTB16(uint32_t x, uint32_t rotate) {
+    return __SXTB16(__ROR(x, rotate));
+}
+
+inline uint32_t __SXTH(uint32_t x) {
+    return static_cast<uint32_t>(static_cast<int32_t>(static_cast<int16_t>(x & 0xffff)));
+}
+
+inline uint32_t __PKHBT(uint32_t a, uint32_t b, uint32_t shift) {
+    return (a & 0xffff) | ((b << shift) & 0xffff0000u);
+}
+
+inline uint32_t __PKHTB(uint32_t a, uint32_t b, uint32_t shift) {
+    return (a & 0xffff0000u) | ((static_cast<uint32_t>(static_cast<int32_t>(b) >> shift)) & 0xffff);
+}
+
+#define __SSAT(x, bits) (host_intrinsics::sat(static_cast<int64_t>(x), (bits)))
+#define __USAT(x, bits) ((x) < 0 ? 0 : ((x) > ((1 << (bits)) - 1) ? ((1 << (bits)) - 1) : (x)))
+
+inline int32_t __QADD(int32_t a, int32_t b) { return host_intrinsics::sat(int64_t{a} + b, 32); }
+inline int32_t __QSUB(int32_t a, int32_t b) { return host_intrinsics::sat(int64_t{a} - b, 32); }
+
+inline uint32_t __QADD16(uint32_t a, uint32_t b) {
+    using namespace host_intrinsics;
+    return pack16(sat(lo16(a) + lo16(b), 16), sat(hi16(a) + hi16(b), 16));
+}
+
+inline uint32_t __QSUB16(uint32_t a, uint32_t b) {
+    using namespace host_intrinsics;
+    return pack16(sat(lo16(a) - lo16(b), 16), sat(hi16(a) - hi16(b), 16));
+}
+
+inline uint32_t __SADD16(uint32_t a, uint32_t b) {
+    using namespace host_intrinsics;
+    return pack16(lo16(a) + lo16(b), hi16(a) + hi16(b));
+}
+
+inline uint32_t __SSUB16(uint32_t a, uint32_t b) {
+    using namespace host_intrinsics;
+    return pack16(lo16(a) - lo16(b), hi16(a) - hi16(b));
+}
+
+inline int32_t __SMUAD(uint32_t a, uint32_t b) {
+    using namespace host_intrinsics;
+    return lo16(a) * lo16(b) + hi16(a) * hi16(b);
+}
+
+inline int32_t __SMUADX(uint32_t a, uint32_t b) {
+    using namespace host_intrinsics;
+    return lo16(a) * hi16(b) + hi16(a) * lo16(b);
+}
+
+inline int32_t __SMUSD(uint32_t a, uint32_t b) {
+    using namespace host_intrinsics;
+    return lo16(a) * lo16(b) - hi16(a) * hi16(b);
+}
+
+inline int32_t __SMUSDX(uint32_t a, uint32_t b) {
+    using namespace host_intrinsics;
+    return lo16(a) * hi16(b) - hi16(a) * lo16(b);
+}
+
+inline int32_t __SMLAD(uint32_t a, uint32_t b, int32_t acc) { return acc + __SMUAD(a, b); }
+inline int32_t __SMLADX(uint32_t a, uint32_t b, int32_t acc) { return acc + __SMUADX(a, b); }
+inline int32_t __SMLSD(uint32_t a, uint32_t b, int32_t acc) { return acc + __SMUSD(a, b); }
+inline int32_t __SMLSDX(uint32_t a, uint32_t b, int32_t acc) { return acc + __SMUSDX(a, b); }
+
+inline int64_t __SMLALD(uint32_t a, uint32_t b, int64_t acc) { return acc + __SMUAD(a, b); }
+inline int64_t __SMLALDX(uint32_t a, uint32_t b, int64_t acc) { return acc + __SMUADX(a, b); }
+inline int64_t __SMLSLD(uint32_t a, uint32_t b, int64_t acc) { return acc + __SMUSD(a, b); }
+inline int64_t __SMLSLDX(uint32_t a, uint32_t b, int64_t acc) { return acc + __SMUSDX(a, b); }
+
+inline int32_t __SMMUL(int32_t a, int32_t b) { return static_cast<int32_t>((int64_t{a} * b) >> 32); }
+
+#endif /*__HOST_HAL_STUB_H__*/
@@ -0,0 +1,270 @@
+/*
+ * Copyright (C) 2025 comparchitect (https://github.com/comparchitect)
+ *
+ * This file is part of PortaPack.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Compares the MBELIB 8 kHz to 48 kHz upsamplers.
+ *
+ * "legacy" is the float triangle interpolation plus 5-point moving average
+ * the MBELIB view used to run; "generic" and "dsp" are the two kernels of
+ * mbelib_audio::Upsampler. Reports whether the two kernels agree bit for
+ * bit, host time per frame, a cycle model for the target cores, and the
+ * passband gain and worst image of each at a set of tones. */
+
+#include "apps/mbelib_audio.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+namespace {
+
+using mbelib_audio::kFrameSamples;
+using mbelib_audio::kUpsampleFactor;
+
+constexpr double kPi = 3.14159265358979323846;
+constexpr size_t kOutputFrameSamples = mbelib_audio::kUpsampledFrameSamples;
+
+/* The pre-polyphase upsampler, kept verbatim for comparison. */
+class LegacyUpsampler {
+   public:
+    size_t process(const int16_t* input, size_t input_count, int16_t* output) {
+        size_t out_idx = 0;
+        for (size_t i = 0; i < input_count; ++i) {
+            const int16_t current_sample = input[i];
+            const int16_t prev_sample = (i == 0 && frame_count_ == 0) ? current_sample : prev_sample_;
+            const float curr_f = static_cast<float>(current_sample);
+            const float prev_f = static_cast<float>(prev_sample);
+
+            output[out_idx++] = static_cast<int16_t>((curr_f * 0.166f) + (prev_f * 0.834f));
+            output[out_idx++] = static_cast<int16_t>((curr_f * 0.332f) + (prev_f * 0.668f));
+            output[out_idx++] = static_cast<int16_t>((curr_f * 0.5f) + (prev_f * 0.5f));
+            output[out_idx++] = static_cast<int16_t>((curr_f * 0.668f) + (prev_f * 0.332f));
+            output[out_idx++] = static_cast<int16_t>((curr_f * 0.834f) + (prev_f * 0.166f));
+            output[out_idx++] = current_sample;
+            prev_sample_ = current_sample;
+        }
+        if (frame_count_ > 0 && out_idx >= 24) {
+            for (size_t i = 12; i < out_idx - 12; ++i) {
+                const int32_t sum = static_cast<int32_t>(output[i - 2]) + output[i - 1] + output[i] +
+                                    output[i + 1] + output[i + 2];
+                output[i] = static_cast<int16_t>(sum / 5);
+            }
+        }
+        frame_count_++;
+        return out_idx;
+    }
+
+   private:
+    int16_t prev_sample_{0};
+    size_t frame_count_{0};
+};
+
+enum class Kind {
+    Legacy,
+    Generic,
+    Dsp
+};
+
+const char* name(Kind kind) {
+    switch (kind) {
+        case Kind::Legacy:
+            return "legacy";
+        case Kind::Generic:
+            return "generic";
+        default:
+            return "dsp";
+    }
+}
+
+/* Runs `frames` 160-sample frames of input through one upsampler. */
+std::vector<int16_t> run(Kind kind, const std::vector<int16_t>& input) {
+    const size_t frames = input.size() / kFrameSamples;
+    std::vector<int16_t> output(frames * kOutputFrameSamples);
+    LegacyUpsampler legacy{};
+    mbelib_audio::Upsampler upsampler{};
+    for (size_t f = 0; f < frames; ++f) {
+        const int16_t* in = input.data() + f * kFrameSamples;
+        int16_t* out = output.data() + f * kOutputFrameSamples;
+        switch (kind) {
+            case Kind::Legacy:
+                legacy.process(in, kFrameSamples, out);
+                break;
+            case Kind::Generic:
+                upsampler.process_generic(in, kFrameSamples, out);
+                break;
+            case Kind::Dsp:
+                upsampler.process_dsp(in, kFrameSamples, out);
+                break;
+        }
+    }
+    return output;
+}
+
+std::vector<int16_t> tone(double hz, double amplitude, size_t frames) {
+    std::vector<int16_t> samples(frames * kFrameSamples);
+    for (size_t n = 0; n < samples.size(); ++n) {
+        samples[n] = static_cast<int16_t>(std::lround(amplitude * std::sin(2.0 * kPi * hz * n / 8000.0)));
+    }
+    return samples;
+}
+
+/* Amplitude of the component at `hz` in a 48 kHz signal (Goertzel). */
+double amplitude_at(const int16_t* samples, size_t count, double hz) {
+    const double w = 2.0 * kPi * hz / mbelib_audio::kPlaybackSampleRate;
+    const double coeff = 2.0 * std::cos(w);
+    double s1 = 0.0;
+    double s2 = 0.0;
+    for (size_t n = 0; n < count; ++n) {
+        const double s0 = samples[n] + coeff * s1 - s2;
+        s2 = s1;
+        s1 = s0;
+    }
+    const double power = s1 * s1 + s2 * s2 - coeff * s1 * s2;
+    return 2.0 * std::sqrt(std::max(power, 0.0)) / static_cast<double>(count);
+}
+
+double db(double ratio) {
+    return 20.0 * std::log10(std::max(ratio, 1e-9));
+}
+
+void frequency_response() {
+    constexpr double kAmplitude = 10000.0;
+    constexpr size_t kFrames = 60;
+    constexpr size_t kSettleFrames = 10;
+    const double tones[] = {300, 500, 1000, 1500, 2000, 2500, 3000, 3400, 3800};
+
+    std::printf("\nfrequency response (gain at the tone / worst image, dB re input):\n");
+    std::printf("  %6s  %16s  %16s\n", "Hz", name(Kind::Legacy), name(Kind::Generic));
+    for (const double hz : tones) {
+        const auto input = tone(hz, kAmplitude, kFrames);
+        std::printf("  %6.0f", hz);
+        for (const Kind kind : {Kind::Legacy, Kind::Generic}) {
+            const auto output = run(kind, input);
+            const int16_t* window = output.data() + kSettleFrames * kOutputFrameSamples;
+            const size_t count = output.size() - kSettleFrames * kOutputFrameSamples;
+
+            const double gain = amplitude_at(window, count, hz) / kAmplitude;
+            double image = 0.0;
+            for (size_t k = 1; k < kUpsampleFactor; ++k) {
+                for (const double f : {8000.0 * k - hz, 8000.0 * k + hz}) {
+                    if (f < 24000.0) {
+                        image = std::max(image, amplitude_at(window, count, f) / kAmplitude);
+                    }
+                }
+            }
+            std::printf("  %7.2f / %6.1f", db(gain), db(image));
+        }
+        std::printf("\n");
+    }
+}
+
+void timing(const std::vector<int16_t>& input) {
+    const size_t frames = input.size() / kFrameSamples;
+    std::printf("\nhost time per 160-sample frame (%zu frames):\n", frames);
+    for (const Kind kind : {Kind::Legacy, Kind::Generic, Kind::Dsp}) {
+        const auto t0 = std::chrono::steady_clock::now();
+        const auto output = run(kind, input);
+        const std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - t0;
+        std::printf("  %-8s %8.0f ns%s\n", name(kind), elapsed.count() / frames,
+                    (kind == Kind::Dsp) ? "  (intrinsics emulated on the host)" : "");
+        if (output.empty()) {
+            std::abort();
+        }
+    }
+}
+
+/* Full-scale input with the signs of one phase's taps: the absolute tap
+ * sum reaches 66186 (phases 2 and 3), so the sum is about twice full scale
+ * and overflows a 32-bit Q30 accumulator. Each kernel must saturate to the
+ * rail of the pattern's sign instead. The taps' signs are read from the
+ * impulse response, which the kernel returns as round(h * 32767 / 32768). */
+bool worst_case(Kind kind) {
+    constexpr size_t kImpulse = 20;
+    constexpr size_t kNewest = 60;
+    constexpr size_t kTaps = mbelib_audio::Upsampler::kTapsPerPhase;
+    std::vector<int16_t> impulse(kFrameSamples, 0);
+    impulse[kImpulse] = 32767;
+    const auto response = run(Kind::Generic, impulse);
+
+    bool ok = true;
+    for (size_t p = 0; p < kUpsampleFactor; ++p) {
+        for (const bool positive : {true, false}) {
+            std::vector<int16_t> input(kFrameSamples, 0);
+            for (size_t j = 0; j < kTaps; ++j) {
+                const int16_t h = response[(kImpulse + kTaps - 1 - j) * kUpsampleFactor + p];
+                input[kNewest + 1 - kTaps + j] = ((h > 0) == positive) ? 32767 : -32768;
+            }
+            const int16_t expected = positive ? 32767 : -32768;
+            const int16_t got = run(kind, input)[kNewest * kUpsampleFactor + p];
+            if (got != expected) {
+                std::printf("  %s phase %zu: %d, expected %d\n", name(kind), p, got, expected);
+                ok = false;
+            }
+        }
+    }
+    return ok;
+}
+
+/* Per-operation cycle model, not a measurement: Cortex-M0 soft-float
+ * fmul/fadd/f2i at about 40/50/30 cycles; Cortex-M4 LDRSH 2, SMLAL 1,
+ * SMLALD 1, LDR 2 (unaligned 3), SSAT/STRH 1 each. */
+void cycle_model() {
+    const double legacy_m0 = kFrameSamples * (5 * (2 * 40 + 50 + 30) + 12) +
+                             (kOutputFrameSamples - 24) * (5 * 2 + 4 * 1 + 40);
+    const double generic_m4 = kFrameSamples * kUpsampleFactor * (mbelib_audio::Upsampler::kTapsPerPhase * (2 + 2 + 1) + 6);
+    const double dsp_m4 = kFrameSamples * (8 * 3 + kUpsampleFactor * (8 * (2 + 1) + 4));
+
+    std::printf("\ncycle model per frame (estimate):\n");
+    std::printf("  legacy  on M0  %8.0f\n", legacy_m0);
+    std::printf("  generic on M4  %8.0f\n", generic_m4);
+    std::printf("  dsp     on M4  %8.0f\n", dsp_m4);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    const size_t frames = (argc > 1) ? static_cast<size_t>(std::max(1, std::atoi(argv[1]))) : 20000;
+
+    std::mt19937 rng{1};
+    std::normal_distribution<double> noise{0.0, 6000.0};
+    std::vector<int16_t> input(frames * kFrameSamples);
+    for (auto& sample : input) {
+        sample = static_cast<int16_t>(std::max(-32768.0, std::min(32767.0, noise(rng))));
+    }
+    // Full-scale steps; worst_case() covers the sign pattern that overflows
+    for (size_t n = 0; n < kFrameSamples * 4 && n < input.size(); ++n) {
+        input[n] = ((n / 7) & 1) ? 32767 : -32768;
+    }
+
+    const bool identical = (run(Kind::Generic, input) == run(Kind::Dsp, input));
+    std::printf("generic vs dsp kernel over %zu frames: %s\n", frames, identical ? "bit-exact" : "MISMATCH");
+    const bool generic_saturates = worst_case(Kind::Generic);
+    const bool saturates = worst_case(Kind::Dsp) && generic_saturates;
+    std::printf("worst-case tap sign pattern at full scale: %s\n", saturates ? "saturates" : "WRAPS");
+
+    timing(input);
+    cycle_model();
+    frequency_response();
+    return (identical && saturates) ? 0 : 1;
+}
@@ -12,6 +12,23 @@ SDCARD_DIR="${ROOT_DIR}/sdcard/APPS"
 
 mkdir -p "${SDCARD_DIR}"
 
+# message.hpp and baseband_api are not part of this overlay; see docs/external/MESSAGES.md
+check_symbol() {
+    local file="$1"
+    local symbol="$2"
+    if [[ -f "${file}" ]] && ! grep -q "${symbol}" "${file}"; then
+        echo "WARNING: ${file} lacks ${symbol} (docs/external/MESSAGES.md)" >&2
+    fi
+}
+
+MESSAGE_HPP="${ROOT_DIR}/firmware/common/message.hpp"
+for symbol in DSDCallEventMessage AMBEWavDataMessage start_sample output_format skipped; do
+    check_symbol "${MESSAGE_HPP}" "${symbol}"
+done
+for symbol in mbelib_decode_stream mbelib_play_samples; do
+    check_symbol "${ROOT_DIR}/firmware/application/baseband_api.hpp" "${symbol}"
+done
+
 copy_artifact() {
     local src="$1"
     local dest="$2"